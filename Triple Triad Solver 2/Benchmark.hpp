@@ -0,0 +1,182 @@
+#pragma once
+#include "defs.hpp"
+#include "Rules.hpp"
+#include "DeckStats.hpp"
+#include "Board.hpp"
+#include "Search.hpp"
+#include "Matchplay.hpp"
+#include <chrono>
+#include <iomanip>
+#include <string>
+
+/* Times full solves of a fixed set of matchups under each ruleset, so rule changes
+to the board or search can be compared against the basic rules on equal footing.
+A few scripted opening moves can be played first, since a solve from the empty
+board takes minutes */
+namespace Benchmark {
+    template <typename RuleSet>
+    static void solveMatchups(const std::string& label, int matchups, int openingMoves = 0) {
+        const int deckCount = DeckStats::deckCount();
+        Search::nodes = 0;
+        const auto start = std::chrono::steady_clock::now();
+
+        // Same deterministic pairings for every ruleset
+        for (int i = 0; i < matchups; i++) {
+            transpositionTable.clear();
+            Board::init((2 * i) % deckCount, (2 * i + 1) % deckCount);
+            for (int move = 0; move < openingMoves; move++) {
+                const auto possibleMoves = Board::getAllPossibleMoves<RuleSet>();
+                Board::makeMove<RuleSet>(possibleMoves[(7 * move + i) % possibleMoves.size()]);
+            }
+            Search::solve<RuleSet>();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::left << std::setw(40) << label
+            << " Matchups: " << matchups
+            << " | Time: " << std::fixed << std::setprecision(3) << seconds << "s"
+            << " | Nodes: " << Search::nodes
+            << " | Nodes/s: " << std::setprecision(0) << (seconds > 0 ? Search::nodes / seconds : 0.0) << std::endl;
+    }
+
+    // Every valid combination of rules. Requires DeckStats to hold at least 2 decks
+    static void rulesets(int matchups, int openingMoves = 0) {
+        std::cout << "----------------------- Ruleset Benchmarks -----------------------" << std::endl;
+        for (Rules::Flags flags = 0; flags <= Rules::ALL_RULES; flags++)
+            if (Rules::isValid(flags))
+                Rules::dispatch(flags, [&](auto ruleset) {
+                    solveMatchups<decltype(ruleset)>(Rules::toString(flags), matchups, openingMoves);
+                });
+    }
+
+    static bool fail(const std::string& check, const std::string& reason) {
+        std::cout << "Check failed: " << check << ": " << reason << std::endl;
+        return false;
+    }
+
+    /* Plays the game on the board to the end, each side taking its first legal move, checking
+    that every move spends exactly one card, then undoes it all and checks that the hands and
+    hash come back */
+    template <typename RuleSet>
+    static bool playoutKeepsHands(const std::string& check) {
+        const CardContainer startHands[PLAYER_COUNT] = { Board::hand[PLAYER_RED], Board::hand[PLAYER_BLUE] };
+        const uint64_t startHash = Board::hash();
+        const size_t startCards = startHands[PLAYER_RED].size() + startHands[PLAYER_BLUE].size();
+        size_t moves = 0;
+        while (!Board::matchEnded()) {
+            if (Board::hand[Board::currentPlayer].empty())
+                return fail(check, "a hand ran out before the board filled");
+            Board::makeMove<RuleSet>(Board::getAllPossibleMoves<RuleSet>().front());
+            moves++;
+            if (Board::hand[PLAYER_RED].size() + Board::hand[PLAYER_BLUE].size() != startCards - moves)
+                return fail(check, "a move spent more than one card");
+        }
+        for (size_t move = 0; move < moves; move++)
+            Board::undoMove<RuleSet>();
+        if (Board::hand[PLAYER_RED] != startHands[PLAYER_RED] || Board::hand[PLAYER_BLUE] != startHands[PLAYER_BLUE]
+            || Board::hash() != startHash)
+            return fail(check, "undoing the game did not restore the hands and hash");
+        return true;
+    }
+
+    /* A Swap between two decks sharing a card: red gives up a card for blue's copy of the
+    shared one, so red's hand holds it twice. Both copies must be playable, under Order too,
+    where an emptied hand used to be read past its end */
+    static bool sharedCardSwap() {
+        for (ID red = 0; red < DeckStats::deckCount(); red++)
+            for (int sharedSlot = 0; sharedSlot < DECK_SIZE; sharedSlot++) {
+                const ID shared = DeckStats::card(red, sharedSlot);
+                for (const ID blue : DeckStats::decksWithCard(shared)) {
+                    if (blue == red)
+                        continue;
+                    const CardContainer blueDeck = DeckStats::deck(blue);
+                    const int blueSlot = int(std::find(blueDeck.begin(), blueDeck.end(), shared) - blueDeck.begin());
+                    const int redSlot = (sharedSlot + 1) % DECK_SIZE;
+
+                    Board::initSwapped(red, blue, redSlot, blueSlot);
+                    if (std::count(Board::hand[PLAYER_RED].begin(), Board::hand[PLAYER_RED].end(), shared) != 2)
+                        return fail("shared card Swap", "red's hand should hold the shared card twice");
+                    if (!playoutKeepsHands<Rules::Basic>("shared card Swap"))
+                        return false;
+                    return Rules::dispatch(Rules::ORDER, [&](auto ruleset) {
+                        Board::initSwapped(red, blue, redSlot, blueSlot);
+                        if (!playoutKeepsHands<decltype(ruleset)>("shared card Swap under Order"))
+                            return false;
+                        transpositionTable.clear();
+                        const double score = Matchplay::swapExpectedScore<decltype(ruleset)>(red, blue, 1);
+                        if (score < 0.0 || score > 1.0)
+                            return fail("shared card Swap under Order", "expected score out of range");
+                        return true;
+                    });
+                }
+            }
+        std::cout << "No two decks share a card, shared card Swap not checked" << std::endl;
+        return true;
+    }
+
+    /* Sudden Death between two decks sharing a card: a drawn game in which one side ends up
+    owning both copies, so its replay hand holds the card twice. The replay must play out
+    soundly, and solving the drawn game's last move must cache what a direct solve of the
+    replay gives. Played under Order, where a replay solves in well under a second */
+    static constexpr int SUDDEN_DEATH_LINES = 64;  // Scripted games tried per deck pair
+
+    template <typename RuleSet>
+    static bool sharedCardSuddenDeath() {
+        const std::string check = "shared card Sudden Death";
+        for (ID red = 0; red < DeckStats::deckCount(); red++)
+            for (int sharedSlot = 0; sharedSlot < DECK_SIZE; sharedSlot++) {
+                const ID shared = DeckStats::card(red, sharedSlot);
+                for (const ID blue : DeckStats::decksWithCard(shared)) {
+                    if (blue == red)
+                        continue;
+                    for (int line = 0; line < SUDDEN_DEATH_LINES; line++) {
+                        Board::init(red, blue);
+                        for (int move = 0; !Board::matchEnded(); move++) {
+                            const auto possibleMoves = Board::getAllPossibleMoves<RuleSet>();
+                            Board::makeMove<RuleSet>(possibleMoves[(7 * move + line) % possibleMoves.size()]);
+                        }
+                        const CardContainer redOwned = Board::ownedCards(PLAYER_RED);
+                        const CardContainer blueOwned = Board::ownedCards(PLAYER_BLUE);
+                        if (Board::winningPlayer() != PLAYER_NONE
+                            || (std::count(redOwned.begin(), redOwned.end(), shared) < 2
+                                && std::count(blueOwned.begin(), blueOwned.end(), shared) < 2))
+                            continue;
+
+                        // The last move has no alternative, so the search reaches this draw
+                        Board::undoMove<RuleSet>();
+                        const uint64_t hash = Board::hash();
+                        SuddenDeath::RoundCache<RuleSet>::solved.clear();
+                        SuddenDeath::roundsLeft = 1;
+                        transpositionTable.clear();
+                        Search::solve<RuleSet>();
+                        SuddenDeath::roundsLeft = 0;
+                        if (Board::hash() != hash)
+                            return fail(check, "the replay did not restore the drawn game");
+                        const auto cached = SuddenDeath::RoundCache<RuleSet>::solved.find(
+                            SuddenDeath::makeKey(redOwned, blueOwned, PLAYER_BLUE, 0));
+                        if (cached == SuddenDeath::RoundCache<RuleSet>::solved.end())
+                            return fail(check, "the replay was not cached");
+
+                        Board::initWithHands(redOwned, blueOwned, PLAYER_BLUE);
+                        if (!playoutKeepsHands<RuleSet>(check))
+                            return false;
+                        transpositionTable.clear();
+                        if (Search::solve<RuleSet>() != cached->second)
+                            return fail(check, "the cached replay differs from a direct solve");
+                        transpositionTable.clear();
+                        return true;
+                    }
+                }
+            }
+        std::cout << "No drawn game between decks sharing a card, " << check << " not checked" << std::endl;
+        return true;
+    }
+
+    // Consistency checks for --check, on the decks in DeckStats. True when all pass
+    static bool runChecks() {
+        bool passed = sharedCardSwap();
+        passed &= Rules::dispatch(Rules::ORDER, [](auto ruleset) { return sharedCardSuddenDeath<decltype(ruleset)>(); });
+        std::cout << (passed ? "All checks passed" : "Some checks failed") << std::endl;
+        return passed;
+    }
+}
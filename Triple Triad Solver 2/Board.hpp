@@ -6,56 +6,145 @@
 #include "PossibleMove.hpp"
 #include "MoveHistory.hpp"
 #include "CardGrid.hpp"
+#include "Rules.hpp"
 
 namespace Board {
     enum Border { TOP_BORDER = 0, RIGHT_BORDER = 2, BOTTOM_BORDER = 2, LEFT_BORDER = 0 };
     static constexpr int WIDTH = 3;
     static constexpr int HEIGHT = 3;
-    static CardContainer hand[PLAYER_COUNT];
-    static ID deck[PLAYER_COUNT];
-    static CardGrid cards;
+    static constexpr int DIRECTION_COL[4] = { 0, 1, 0, -1 }; // Indexed by Edge
+    static constexpr int DIRECTION_ROW[4] = { -1, 0, 1, 0 };
+    // Solver state is per thread, so parallel workers each get their own board
+    static thread_local CardContainer hand[PLAYER_COUNT];
+    static thread_local ID deck[PLAYER_COUNT];
+    static thread_local CardGrid cards;
+
+    static thread_local Player currentPlayer;
+    static thread_local Player startingPlayer; // Whoever opened the current game; alternates between Sudden Death rounds
+    static thread_local uint64_t positionHash; // Maintained incrementally by makeMove() / undoMove()
+    static thread_local int typeCount[TYPE_COUNT]; // Cards of each type on the board, tracked under Ascension / Descension
+
+    // Zobrist-style keys, derived by mixing the feature rather than stored in a table
+    static constexpr uint64_t SIDE_TO_MOVE_KEY = 0x5851F42D4C957F2Dull;
+
+    static uint64_t cellKey(int cell, ID card, Player owner) {
+        return mix64((uint64_t(cell) << 40) | (uint64_t(owner) << 32) | uint64_t(card));
+    }
 
-    static Player currentPlayer;
+    /* A hand can hold two copies of a card when both decks have it: a Swap or a Sudden Death
+    capture hands one player the other's copy. Each copy gets its own key, so the hash tells
+    one copy from two; copy 0 keys as a hand of unique cards always did */
+    static uint64_t handKey(Player player, ID card, int copy) {
+        return mix64((1ull << 48) | (uint64_t(copy) << 40) | (uint64_t(player) << 32) | uint64_t(card));
+    }
 
-    static void init(ID redDeck, ID blueDeck) {
-        deck[PLAYER_RED] = redDeck; 
-        deck[PLAYER_BLUE] = blueDeck;
-        hand[PLAYER_RED] = DeckStats::deck(redDeck);
-        hand[PLAYER_BLUE] = DeckStats::deck(blueDeck);
+    static int copiesInHand(Player player, ID card) {
+        return int(std::count(hand[player].begin(), hand[player].end(), card));
+    }
+
+    static void sortHand(const Player player) {
+        std::sort(hand[player].begin(), hand[player].end(), std::greater<ID>());
+    }
+
+    // Starts a game from explicit hands, e.g. a Sudden Death replay. Leaves deck[] untouched
+    static void initWithHands(const CardContainer& redHand, const CardContainer& blueHand, Player firstPlayer) {
+        hand[PLAYER_RED] = redHand;
+        hand[PLAYER_BLUE] = blueHand;
+        sortHand(PLAYER_RED);
+        sortHand(PLAYER_BLUE);
 
         initCardGrid(cards, WIDTH, HEIGHT);
         for (int row = 0; row < HEIGHT; row++)
             for (int col = 0; col < WIDTH; col++)
                 cards[col][row] = CardCollection::getEmpty();
 
-        currentPlayer = PLAYER_RED;
+        for (int type = 0; type < TYPE_COUNT; type++)
+            typeCount[type] = 0;
+
+        currentPlayer = firstPlayer;
+        startingPlayer = firstPlayer;
+
+        // The board starts empty, so only the hands and side to move contribute to the hash
+        positionHash = currentPlayer == PLAYER_BLUE ? SIDE_TO_MOVE_KEY : 0;
+        for (int player = 0; player < PLAYER_COUNT; player++)
+            for (int card = 0, copy = 0; card < hand[player].size(); card++) {
+                copy = card > 0 && hand[player][card] == hand[player][card - 1] ? copy + 1 : 0; // Sorted, so copies are adjacent
+                positionHash ^= handKey(Player(player), hand[player][card], copy);
+            }
     }
 
-    static int hash() {
-        int h = 0;
-        std::hash<int> hasher;
+    static void init(ID redDeck, ID blueDeck) {
+        deck[PLAYER_RED] = redDeck;
+        deck[PLAYER_BLUE] = blueDeck;
+        initWithHands(DeckStats::deck(redDeck), DeckStats::deck(blueDeck), PLAYER_RED);
+    }
 
-        // Hash board state (card IDs + controlling colors)
-        for (int row = 0; row < HEIGHT; ++row)
-            for (int col = 0; col < WIDTH; ++col)
-                h ^= hasher(cards[row][col].id()) ^ (hasher(cards[row][col].controllingPlayer()) << 1);
+    // Swap rule: red's card at redIndex and blue's card at blueIndex trade places before the game
+    static void initSwapped(ID redDeck, ID blueDeck, int redIndex, int blueIndex) {
+        CardContainer redHand = DeckStats::deck(redDeck);
+        CardContainer blueHand = DeckStats::deck(blueDeck);
+        std::swap(redHand[redIndex], blueHand[blueIndex]);
 
-        // Hash player hands (requires hands to be sorted)
-        for (int player = 0; player < PLAYER_COUNT; ++player)
-            for (int card = 0; card < hand[player].size(); ++card)
-                h ^= hasher(hand[player][card]) << 3;
+        deck[PLAYER_RED] = redDeck;
+        deck[PLAYER_BLUE] = blueDeck;
+        initWithHands(redHand, blueHand, PLAYER_RED);
+    }
 
-        // Hash the player to move (assuming Player is an enum)
-        h ^= hasher(currentPlayer) << 5;
+    // Everything a nested game (Sudden Death) overwrites, so the outer game can be resumed
+    struct Snapshot {
+        CardContainer hand[PLAYER_COUNT];
+        CardGrid cards;
+        Player currentPlayer, startingPlayer;
+        uint64_t positionHash;
+        int typeCount[TYPE_COUNT];
+    };
+
+    static Snapshot save() {
+        Snapshot snapshot{ { hand[PLAYER_RED], hand[PLAYER_BLUE] }, cards, currentPlayer, startingPlayer, positionHash };
+        std::copy(typeCount, typeCount + TYPE_COUNT, snapshot.typeCount);
+        return snapshot;
+    }
 
-        return h;
+    static void restore(const Snapshot& snapshot) {
+        hand[PLAYER_RED] = snapshot.hand[PLAYER_RED];
+        hand[PLAYER_BLUE] = snapshot.hand[PLAYER_BLUE];
+        cards = snapshot.cards;
+        currentPlayer = snapshot.currentPlayer;
+        startingPlayer = snapshot.startingPlayer;
+        positionHash = snapshot.positionHash;
+        std::copy(snapshot.typeCount, snapshot.typeCount + TYPE_COUNT, typeCount);
+    }
+
+    /* Keys on (cell, card, owner) for every placed card, the hands and the side to move.
+    Effective edge values under Ascension / Descension follow from which cards are on the
+    board, so they need no key of their own */
+    static uint64_t hash() {
+        return positionHash;
     }
 
     static bool isEmpty(int col, int row) {
         return cards[col][row].controllingPlayer() == PLAYER_NONE;
     }
 
+    // Every empty cell for one given card: a Chaos turn once the forced card is known
+    static std::vector<PossibleMove> getMovesForCard(ID card) {
+        std::vector<PossibleMove> possibleMoves;
+        for (int col = 0; col < WIDTH; col++)
+            for (int row = 0; row < HEIGHT; row++)
+                if (isEmpty(col, row))
+                    possibleMoves.emplace_back(col, row, card);
+
+        return possibleMoves;
+    }
+
+    /* Under Order only the next card in deck order may be played. Hands are kept sorted
+    in descending ID order and decks ascending, so that card is always the last one.
+    Chaos lists every card: Search draws the forced one itself as a chance node */
+    template <typename RuleSet = Rules::Basic>
     static std::vector<PossibleMove> getAllPossibleMoves()  {
+        if constexpr (RuleSet::HAND == Rules::ORDER_HAND)
+            return getMovesForCard(hand[currentPlayer].back());
+
         const int handSize = hand[currentPlayer].size();
         std::vector<PossibleMove> possibleMoves;
         for (int col = 0; col < WIDTH; col++)
@@ -71,78 +160,190 @@ namespace Board {
         return col < 0 || col >= WIDTH || row < 0 || row >= HEIGHT;
     }
 
-    static void sortHand(const Player player) {
-        std::sort(hand[player].begin(), hand[player].end(), std::greater<ID>());
+    // Plays a single copy of the card, should the hand hold two
+    static void removeCardFromHand(const Player player, const ID id) {
+        hand[player].erase(std::find(hand[player].begin(), hand[player].end(), id));
+        positionHash ^= handKey(player, id, copiesInHand(player, id));
     }
 
-    static void removeCardFromHand(const Player player, const ID id) {
-        hand[player].erase(
-            std::remove(hand[player].begin(), hand[player].end(), id), hand[player].end()
-        );
+    static void returnCardToHand(const Player player, const ID id) {
+        positionHash ^= handKey(player, id, copiesInHand(player, id));
+        hand[player].push_back(id);
+        sortHand(player);
     }
 
     static void swapTurn() {
         currentPlayer = otherPlayer(currentPlayer);
+        positionHash ^= SIDE_TO_MOVE_KEY;
+    }
+
+    static Edge opposite(Edge edge) {
+        return Edge((edge + 2) % 4);
     }
 
     static void flip(Card& card) {
         card.setControllingPlayer(otherPlayer(card.controllingPlayer()));
     }
 
-    static void resolveFlipsAndRecordThem(PossibleMove move) {
-        const int col = move.col; const int row = move.row;
+    static int cellIndex(int col, int row) {
+        return col * HEIGHT + row;
+    }
+
+    static void flipAt(int col, int row) {
+        const int cell = cellIndex(col, row);
+        const ID id = cards[col][row].id();
+        positionHash ^= cellKey(cell, id, PLAYER_RED) ^ cellKey(cell, id, PLAYER_BLUE);
+        flip(cards[col][row]);
+    }
+
+    // Re-derives the edges of every board card of this type from the current type count
+    template <typename RuleSet>
+    static void refreshTypeModifier(CardType type) {
+        const int modifier = RuleSet::TYPE_MODIFIER * typeCount[type];
+        for (int col = 0; col < WIDTH; col++)
+            for (int row = 0; row < HEIGHT; row++)
+                if (cards[col][row].hasOwner() && cards[col][row].type() == type)
+                    cards[col][row].applyModifier(CardCollection::card(cards[col][row].id()), modifier);
+    }
+
+    // Records the flip so undoMove() can revert it, and queues it for Combo if requested
+    static void flipAndRecord(int col, int row, int* combo, int& comboCount) {
+        flipAt(col, row);
+        MoveHistory::addFlip(cellIndex(col, row));
+        if (combo)
+            combo[comboCount++] = cellIndex(col, row);
+    }
+
+    template <typename RuleSet>
+    static bool captures(int attackingEdge, int defendingEdge) {
+        return Rules::Compare::captures<typename RuleSet::Comparator>(attackingEdge, defendingEdge);
+    }
+
+    // Basic rule: the card at (col, row) flips adjacent enemies whose touching edge it beats
+    template <typename RuleSet>
+    static void resolveBasicFlips(int col, int row, int* combo, int& comboCount) {
         const Card& placedCard = cards[col][row];
 
         // Right Flips
         if (!adjacentPosOOB(col + 1, row)) {
             Card& adjacentCard = cards[col + 1][row];
             if (placedCard.isEnemy(adjacentCard))
-                if (placedCard.attribute(RIGHT) > adjacentCard.attribute(LEFT)) {
-                    MoveHistory::addFlip(move, RIGHT);
-                    flip(adjacentCard);
-                }
+                if (captures<RuleSet>(placedCard.attribute(RIGHT), adjacentCard.attribute(LEFT)))
+                    flipAndRecord(col + 1, row, combo, comboCount);
         }
 
         // Left Flips
         if (!adjacentPosOOB(col - 1, row)) {
             Card& adjacentCard = cards[col - 1][row];
             if (placedCard.isEnemy(adjacentCard))
-                if (placedCard.attribute(LEFT) > adjacentCard.attribute(RIGHT)) {
-                    MoveHistory::addFlip(move, LEFT);
-                    adjacentCard.setControllingPlayer(placedCard.controllingPlayer());
-                }
+                if (captures<RuleSet>(placedCard.attribute(LEFT), adjacentCard.attribute(RIGHT)))
+                    flipAndRecord(col - 1, row, combo, comboCount);
         }
 
         // Top Flips
         if (!adjacentPosOOB(col, row - 1)) {
             Card& adjacentCard = cards[col][row - 1];
             if (placedCard.isEnemy(adjacentCard))
-                if (placedCard.attribute(TOP) > adjacentCard.attribute(BOTTOM)) {
-                    MoveHistory::addFlip(move, TOP);
-                    adjacentCard.setControllingPlayer(placedCard.controllingPlayer());
-                }
+                if (captures<RuleSet>(placedCard.attribute(TOP), adjacentCard.attribute(BOTTOM)))
+                    flipAndRecord(col, row - 1, combo, comboCount);
         }
 
         // Bottom Flips
         if (!adjacentPosOOB(col, row + 1)) {
             Card& adjacentCard = cards[col][row + 1];
             if (placedCard.isEnemy(adjacentCard))
-                if (placedCard.attribute(BOTTOM) > adjacentCard.attribute(TOP)) {
-                    MoveHistory::addFlip(move, BOTTOM);
-                    adjacentCard.setControllingPlayer(placedCard.controllingPlayer());
-                }
+                if (captures<RuleSet>(placedCard.attribute(BOTTOM), adjacentCard.attribute(TOP)))
+                    flipAndRecord(col, row + 1, combo, comboCount);
         }
     }
 
-    static void placeCard(PossibleMove move) {
-        cards[move.col][move.row] = CardCollection::card(move.card);
-        cards[move.col][move.row].setControllingPlayer(currentPlayer);
+    // Same / Plus: compare the placed card against every occupied neighbour (friendly or not),
+    // and if 2+ sides match, flip the enemies among them. Returns the flips via the combo worklist
+    template <typename RuleSet>
+    static void resolveSameAndPlusFlips(int col, int row, int* combo, int& comboCount) {
+        const Card& placedCard = cards[col][row];
+        bool occupied[4] = { false, false, false, false };
+        int touching[4], sums[4];
+        int sameCount = 0;
+
+        for (int edge = 0; edge < 4; edge++) {
+            const int adjacentCol = col + DIRECTION_COL[edge];
+            const int adjacentRow = row + DIRECTION_ROW[edge];
+            if (adjacentPosOOB(adjacentCol, adjacentRow) || !cards[adjacentCol][adjacentRow].hasOwner())
+                continue;
+
+            occupied[edge] = true;
+            touching[edge] = cards[adjacentCol][adjacentRow].attribute(opposite(Edge(edge)));
+            sums[edge] = attributeRank(placedCard.attribute(edge)) + attributeRank(touching[edge]);
+            if (touching[edge] == placedCard.attribute(edge))
+                sameCount++;
+        }
+
+        bool triggered[4] = { false, false, false, false };
+        for (int edge = 0; edge < 4; edge++) {
+            if (!occupied[edge])
+                continue;
+            if constexpr (RuleSet::SAME)
+                if (sameCount >= 2 && touching[edge] == placedCard.attribute(edge))
+                    triggered[edge] = true;
+            if constexpr (RuleSet::PLUS)
+                for (int other = 0; other < 4; other++)
+                    if (other != edge && occupied[other] && sums[other] == sums[edge])
+                        triggered[edge] = true;
+        }
+
+        for (int edge = 0; edge < 4; edge++) {
+            const int adjacentCol = col + DIRECTION_COL[edge];
+            const int adjacentRow = row + DIRECTION_ROW[edge];
+            if (triggered[edge] && placedCard.isEnemy(cards[adjacentCol][adjacentRow]))
+                flipAndRecord(adjacentCol, adjacentRow, combo, comboCount);
+        }
+    }
+
+    template <typename RuleSet>
+    static void resolveFlipsAndRecordThem(PossibleMove move) {
+        int unused = 0;
+        if constexpr (RuleSet::SAME || RuleSet::PLUS) {
+            // Combo worklist: a card can only flip once per move, so it never outgrows the board
+            int combo[WIDTH * HEIGHT];
+            int comboCount = 0;
+            resolveSameAndPlusFlips<RuleSet>(move.col, move.row, combo, comboCount);
+
+            // Cards flipped by Same/Plus capture their own neighbours with the basic rule, and so on
+            if constexpr (RuleSet::COMBO)
+                for (int next = 0; next < comboCount; next++)
+                    resolveBasicFlips<RuleSet>(combo[next] / HEIGHT, combo[next] % HEIGHT, combo, comboCount);
+        }
 
-        resolveFlipsAndRecordThem(move);
+        resolveBasicFlips<RuleSet>(move.col, move.row, nullptr, unused);
+    }
+
+    template <typename RuleSet = Rules::Basic>
+    static void placeCard(PossibleMove move) {
+        Card& placedCard = cards[move.col][move.row];
+        placedCard = CardCollection::card(move.card);
+        placedCard.setControllingPlayer(currentPlayer);
+        positionHash ^= cellKey(cellIndex(move.col, move.row), move.card, currentPlayer);
+
+        // The placed card takes the modifier from the same-typed cards already on the board...
+        const CardType type = placedCard.type();
+        if constexpr (RuleSet::TYPE_MODIFIER != 0)
+            if (type != TYPE_NONE && typeCount[type] > 0)
+                placedCard.applyModifier(CardCollection::card(move.card), RuleSet::TYPE_MODIFIER * typeCount[type]);
+
+        resolveFlipsAndRecordThem<RuleSet>(move);
+
+        // ...and then counts towards the modifier of every card of its type, itself included
+        if constexpr (RuleSet::TYPE_MODIFIER != 0)
+            if (type != TYPE_NONE) {
+                typeCount[type]++;
+                refreshTypeModifier<RuleSet>(type);
+            }
     }
 
+    template <typename RuleSet = Rules::Basic>
     static void makeMove(PossibleMove move) {
-        placeCard(move);
+        placeCard<RuleSet>(move);
         removeCardFromHand(currentPlayer, move.card);
         sortHand(currentPlayer);
         swapTurn();
@@ -153,37 +354,35 @@ namespace Board {
         MoveHistory::finishMove();
     }
 
+    template <typename RuleSet = Rules::Basic>
     static void undoMove() {
         //std::cout << "Move history size: " << MoveHistory::moveHistory.size() << std::endl;
         const PossibleMove lastMove = MoveHistory::getLast().move;
+        Card& placedCard = cards[lastMove.col][lastMove.row];
+        const CardType type = placedCard.type();
         // Remove card from the board
         //std::cout << "Replacing card: " << CardCollection::name(cards[lastMove.col][lastMove.row].id()) << " with empty." << std::endl;
-        cards[lastMove.col][lastMove.row] = CardCollection::getEmpty();
+        positionHash ^= cellKey(cellIndex(lastMove.col, lastMove.row), lastMove.card, placedCard.controllingPlayer());
+        placedCard = CardCollection::getEmpty();
+
+        // Remaining cards of its type lose the modifier it contributed
+        if constexpr (RuleSet::TYPE_MODIFIER != 0)
+            if (type != TYPE_NONE) {
+                typeCount[type]--;
+                refreshTypeModifier<RuleSet>(type);
+            }
 
-        // Restore flipped cards
-        if (MoveHistory::getLast().flipped[TOP]) {
-            flip(cards[lastMove.col][lastMove.row - 1]);
-            //std::cout << "Undoing top flip" << std::endl;
-        }
-        if (MoveHistory::getLast().flipped[RIGHT]) {
-            flip(cards[lastMove.col + 1][lastMove.row]);
-            //std::cout << "Undoing right flip" << std::endl;
-        }
-        if (MoveHistory::getLast().flipped[BOTTOM]) {
-            flip(cards[lastMove.col][lastMove.row + 1]);
-            //std::cout << "Undoing bottom flip" << std::endl;
-        }
-        if (MoveHistory::getLast().flipped[LEFT]) {
-            flip(cards[lastMove.col - 1][lastMove.row]);
-            //std::cout << "Undoing left flip" << std::endl;
-        }
+        // Restore flipped cards, including every card of a Combo chain
+        const uint16_t flipped = MoveHistory::getLast().flipped;
+        for (int cell = 0; cell < WIDTH * HEIGHT; cell++)
+            if (flipped & (1u << cell))
+                flipAt(cell / HEIGHT, cell % HEIGHT);
 
         const Player previousPlayer = otherPlayer(currentPlayer);
 
         // Replace the card back into player's hand
         //std::cout << "Adding card back to player's hand: " << CardCollection::name(lastMove.card) << std::endl;
-        hand[previousPlayer].push_back(lastMove.card);
-        sortHand(previousPlayer);
+        returnCardToHand(previousPlayer, lastMove.card);
 
         // Restore the previous player as the new current one
         swapTurn();
@@ -222,11 +421,23 @@ namespace Board {
                     cardsControlled[controllingPlayer]++;
             }
 
-        cardsControlled[PLAYER_BLUE]++; // Blue also controls their unplayed card
+        // The player who moved second also controls their unplayed card
+        for (int player = 0; player < PLAYER_COUNT; player++)
+            cardsControlled[player] += hand[player].size();
         if (cardsControlled[PLAYER_RED] > cardsControlled[PLAYER_BLUE])
             return PLAYER_RED;
         if (cardsControlled[PLAYER_BLUE] > cardsControlled[PLAYER_RED])
             return PLAYER_BLUE;
         return PLAYER_NONE; // Tie
     }
+
+    // The cards a player ends the game owning: those of their colour on the board plus any left in hand
+    static CardContainer ownedCards(Player player) {
+        CardContainer owned = hand[player];
+        for (int col = 0; col < WIDTH; col++)
+            for (int row = 0; row < HEIGHT; row++)
+                if (cards[col][row].controllingPlayer() == player)
+                    owned.push_back(cards[col][row].id());
+        return owned;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include "defs.hpp"
+#include "MatchRecord.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* Batch ratings: the maximum-likelihood fit of the Bradley-Terry model with Davidson's ties
+over every recorded game at once, so unlike sequential ELO they don't depend on the order
+games were played in. Deck i beats j with probability g_i / D and draws with nu sqrt(g_i g_j) / D,
+where D = g_i + g_j + nu sqrt(g_i g_j). Strengths are fitted by Hunter's minorisation-maximisation
+fixed point, all decks updated together from the last iteration's values, so decks are split
+between threads. Every deck also gets one win and one loss against a reference deck of
+strength 1, which keeps decks that never won or never lost finite; strengths are rescaled
+to a geometric mean of 1 each iteration, which is what the reference deck is measured
+against. Ratings are reported on the ELO scale: 1200 + 400 log10(g) */
+namespace BradleyTerry {
+    static constexpr double PRIOR_GAMES = 2.0;     // Half won, half lost against the reference deck
+    static constexpr double TOLERANCE = 0.01;      // Largest rating change, in ELO points, once converged
+    static constexpr int MAX_ITERATIONS = 10000;
+
+    static std::vector<double> ratings;
+    static double tieParameter = 0.0;   // nu
+    static int iterations = 0;
+
+    static double rating(ID deck) {
+        return deck < ID(ratings.size()) ? ratings[deck] : -1.0;
+    }
+
+    /* Fits ratings for decks 0 to deckCount - 1 from games. Each deck's games are gathered
+    into one adjacency array first, so an iteration is a pass over 2 entries per game */
+    static void fit(const std::vector<GameResult>& games, int deckCount,
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency())) {
+        const auto start = std::chrono::steady_clock::now();
+
+        // Points (1 win, 0.5 draw) and opponents of every deck
+        std::vector<double> points(deckCount, 0.0);
+        std::vector<uint64_t> offsets(size_t(deckCount) + 1, 0);
+        double ties = 0.0;
+        for (const GameResult& game : games) {
+            offsets[game.redDeck + 1]++;
+            offsets[game.blueDeck + 1]++;
+            points[game.redDeck] += 0.5 * game.redHalfPoints;
+            points[game.blueDeck] += 0.5 * (2 - game.redHalfPoints);
+            ties += game.redHalfPoints == 1;
+        }
+        for (int deck = 0; deck < deckCount; deck++)
+            offsets[deck + 1] += offsets[deck];
+        std::vector<uint32_t> opponents(offsets[deckCount]);
+        {
+            std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+            for (const GameResult& game : games) {
+                opponents[next[game.redDeck]++] = game.blueDeck;
+                opponents[next[game.blueDeck]++] = game.redDeck;
+            }
+        }
+
+        /* Threads only write their own decks' entries; the sums over decks are taken in
+        deck order afterwards, so the fit is identical for any thread count */
+        std::vector<double> strength(deckCount, 1.0), root(deckCount, 1.0), updated(deckCount), tieTerms(deckCount);
+        double nu = ties > 0.0 ? 1.0 : 0.0;
+        for (iterations = 1; iterations <= MAX_ITERATIONS; iterations++) {
+            parallelRanges(deckCount, threads, [&](int first, int last, unsigned int) {
+                for (int i = first; i < last; i++) {
+                    const double inverseRoot = 1.0 / root[i];
+                    double denominator = PRIOR_GAMES / (strength[i] + 1.0), tieTerm = 0.0;
+                    for (uint64_t k = offsets[i]; k < offsets[i + 1]; k++) {
+                        const uint32_t j = opponents[k];
+                        const double geometric = root[i] * root[j];
+                        const double inverseD = 1.0 / (strength[i] + strength[j] + nu * geometric);
+                        denominator += (1.0 + 0.5 * nu * root[j] * inverseRoot) * inverseD;
+                        tieTerm += geometric * inverseD;
+                    }
+                    updated[i] = (0.5 * PRIOR_GAMES + points[i]) / denominator;
+                    tieTerms[i] = tieTerm;
+                }
+            });
+
+            double logMean = 0.0;
+            for (int deck = 0; deck < deckCount; deck++)
+                logMean += std::log10(updated[deck]);
+            const double scale = std::pow(10.0, -logMean / std::max(deckCount, 1));
+
+            double change = 0.0, tieTerm = 0.0;
+            for (int deck = 0; deck < deckCount; deck++) {
+                updated[deck] *= scale;
+                change = std::max(change, std::abs(std::log10(updated[deck] / strength[deck])));
+                tieTerm += tieTerms[deck];
+                root[deck] = std::sqrt(updated[deck]);
+            }
+            strength.swap(updated);
+            if (ties > 0.0)
+                nu = ties / (0.5 * tieTerm); // Every game was counted from both sides
+
+            if (400.0 * change < TOLERANCE)
+                break;
+        }
+
+        tieParameter = nu;
+        ratings.resize(deckCount);
+        for (int deck = 0; deck < deckCount; deck++)
+            ratings[deck] = 1200.0 + 400.0 * std::log10(strength[deck]);
+
+        std::cout << "Bradley-Terry: " << games.size() << " games, " << std::min(iterations, MAX_ITERATIONS)
+            << " iterations, tie parameter " << nu << ", "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+    }
+
+    static std::vector<ID> getTopDecks(int numTopDecks) {
+        std::vector<ID> sortedDecks(ratings.size());
+        for (ID deck = 0; deck < ID(sortedDecks.size()); deck++)
+            sortedDecks[deck] = deck;
+        numTopDecks = std::min(numTopDecks, int(sortedDecks.size()));
+        std::partial_sort(sortedDecks.begin(), sortedDecks.begin() + numTopDecks, sortedDecks.end(),
+            [](ID a, ID b) { return ratings[a] != ratings[b] ? ratings[a] > ratings[b] : a < b; });
+        sortedDecks.resize(numTopDecks);
+        return sortedDecks;
+    }
+}
@@ -1,22 +1,24 @@
 #pragma once
 #include "Defs.hpp"
+#include "helpers.hpp"
 
 class Card {
 private:
     int myAttributes[4] = { 0, 0, 0, 0 };
     ID myID = 0;
     int myStarCount = 0;
+    CardType myType = TYPE_NONE;
     Player myControllingPlayer = PLAYER_NONE;
 
 public:
     Card() = default;
 
-    Card(ID id, int stars, int top, int right, int bottom, int left, Player controllingPlayer)
-        : myID(id), myStarCount(stars), myControllingPlayer(controllingPlayer), myAttributes{ top, right, bottom, left } {
+    Card(ID id, int stars, int top, int right, int bottom, int left, Player controllingPlayer, CardType type = TYPE_NONE)
+        : myID(id), myStarCount(stars), myType(type), myControllingPlayer(controllingPlayer), myAttributes{ top, right, bottom, left } {
     }
 
     // Getters
-    const bool& isEnemy(const Card& other) const {
+    bool isEnemy(const Card& other) const {
         return other.controllingPlayer() != PLAYER_NONE && controllingPlayer() != PLAYER_NONE && other.controllingPlayer() != controllingPlayer();
     }
 
@@ -24,6 +26,10 @@ public:
         return myStarCount;
     }
 
+    const CardType& type() const {
+        return myType;
+    }
+
     const Player& controllingPlayer() const {
         return myControllingPlayer;
     }
@@ -48,4 +54,10 @@ public:
     void setControllingPlayer(const Player& player) {
         myControllingPlayer = player;
     }
+
+    // Sets every edge to the base card's edge shifted by modifier (Ascension / Descension)
+    void applyModifier(const Card& base, int modifier) {
+        for (int edge = 0; edge < 4; edge++)
+            myAttributes[edge] = rankToAttribute(attributeRank(base.attribute(edge)) + modifier);
+    }
 };
\ No newline at end of file
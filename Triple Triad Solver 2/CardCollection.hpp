@@ -2,6 +2,7 @@
 #include "defs.hpp"
 #include "helpers.hpp"
 #include "Card.hpp"
+#include "Random.hpp"
 #include <string>
 #include <iostream>
 
@@ -9,26 +10,28 @@ class CardCollection {
 private:
     inline static std::vector<Card> cards;
     inline static std::vector<std::string> names;
+    inline static std::vector<ID> byStars[STARS_MAX + 1]; // Card IDs of each rarity, ascending. Index 0 holds the empty card
 
     // Adds a manually defined card from the game into the global collection
     static void add(const std::string& name, int stars,
-        int top, int right, int bottom, int left) {
+        int top, int right, int bottom, int left, CardType type = TYPE_NONE) {
         const ID id = cards.size();
-        cards.emplace_back(id, stars, top, right, bottom, left, Player::PLAYER_NONE);
+        cards.emplace_back(id, stars, top, right, bottom, left, Player::PLAYER_NONE, type);
         names.push_back(name);
+        byStars[stars].push_back(id);
     }
 public:
     static int cardCount() {
         return cards.size();
     }
 
-    static Card card(const ID id) {
+    static const Card& card(const ID id) {
         return cards[id];
     }
 
     // Initalize all 435 triple triad cards currently in ffxiv
     static void init() {
-        // Card Stat Ordering: Top, Right, Bottom, Left (Clockwise)
+        // Card Stat Ordering: Top, Right, Bottom, Left (Clockwise), then the card type if it has one
         // ______ EMPTY CARD _________
         add("EMPTY CARD", 0, 0, 0, 0, 0); // #0
 
@@ -47,38 +50,38 @@ public:
         add("Ahriman", stars, 5, 5, 2, 2); // #11
         add("Goobbue", stars, 2, 5, 5, 2); // #12
         add("Chocobo", stars, 3, 7, 2, 1); // #13
-        add("Amalj'aa", stars, 1, 4, 7, 1); // #14
-        add("Ixal", stars, 6, 1, 3, 4); // #15
-        add("Sylph", stars, 2, 4, 5, 4); // #16
-        add("Kobold", stars, 2, 2, 4, 6); // #17
-        add("Sahagin", stars, 4, 5, 3, 3); // #18
-        add("Tataru Taru", stars, 7, 2, 3, 2); // #19
-        add("Moogle", stars, 2, 1, 3, 7); // #20
+        add("Amalj'aa", stars, 1, 4, 7, 1, BEASTMAN); // #14
+        add("Ixal", stars, 6, 1, 3, 4, BEASTMAN); // #15
+        add("Sylph", stars, 2, 4, 5, 4, BEASTMAN); // #16
+        add("Kobold", stars, 2, 2, 4, 6, BEASTMAN); // #17
+        add("Sahagin", stars, 4, 5, 3, 3, BEASTMAN); // #18
+        add("Tataru Taru", stars, 7, 2, 3, 2, SCION); // #19
+        add("Moogle", stars, 2, 1, 3, 7, BEASTMAN); // #20
         add("Gaelicat", stars, 4, 1, 1, 7); // #81
         add("Deepeye", stars, 1, 3, 7, 2); // #101
         add("Apkallu", stars, 3, 4, 4, 1); // #154
         add("Colibri", stars, 6, 1, 4, 1); // #155
-        add("Magitek Death Claw", stars, 4, 3, 2, 3); // #156
+        add("Magitek Death Claw", stars, 4, 3, 2, 3, GARLEAN); // #156
         add("Opo-opo", stars, 1, 4, 2, 6); // #169
-        add("Namazu", stars, 1, 6, 1, 5); // #183
+        add("Namazu", stars, 1, 6, 1, 5, BEASTMAN); // #183
         add("Mossling", stars, 5, 2, 5, 1); // #203
         add("Koja", stars, 3, 2, 1, 6); // #211
         add("Wanyudo & Katasharin", stars, 6, 1, 1, 5); // #221
         add("Karakuri Hanya", stars, 7, 1, 1, 4); // #231
-        add("Stormblood Tataru Taru", stars, 1, 4, 1, 7); // #241
+        add("Stormblood Tataru Taru", stars, 1, 4, 1, 7, SCION); // #241
         add("Amaro", stars, 1, 7, 2, 3); // #253
         add("Evil Weapon", stars, 7, 2, 2, 2); // #254     
         add("Lord and Lady Chai", stars, 5, 1, 6, 1); // #255
         add("Hobgoblin", stars, 2, 7, 2, 2); // #273   
         add("Porxie", stars, 1, 2, 6, 4); // #274
         add("Flower Basket", stars, 2, 2, 2, 7); // #283
-        add("Qitari", stars, 4, 6, 2, 2); // #284 
-        add("Dwarf", stars, 2, 4, 6, 2); // #294 
+        add("Qitari", stars, 4, 6, 2, 2, BEASTMAN); // #284 
+        add("Dwarf", stars, 2, 4, 6, 2, BEASTMAN); // #294 
         add("Great Azuro", stars, 4, 7, 1, 1); // #305
 		add("Troll", stars, 4, 4, 3, 4); // #327    
 		add("Pisaca", stars, 3, 4, 4, 4); // #328   
 		add("Ea", stars, 5, 4, 1, 4); // #329   
-		add("Arkasodara", stars, 4, 4, 7, 4); // #330
+		add("Arkasodara", stars, 4, 4, 7, 4, BEASTMAN); // #330
 		add("Rampart", stars, 1, 6, 5, 1); // #347
 		add("Hippo Cart", stars, 1, 1, 7, 4); // #348 
 		add("N-7000", stars, 1, 5, 1, 6); // #357
@@ -86,7 +89,7 @@ public:
 		add("Dreamingway", stars, 2, 5, 5, 2); // #369
 		add("Okuri Chochin", stars, 4, 5, 1, 4); // #378
 		add("Ketuduke", stars, 2, 3, 4, 3); // #389
-		add("Pelupelu", stars, 5, 3, 4, 2); // #406  
+		add("Pelupelu", stars, 5, 3, 4, 2, BEASTMAN); // #406  
 		add("Alpaca", stars, 3, 5, 3, 3); // #407 
 
         // ______ 2-STAR CARDS _______
@@ -101,15 +104,15 @@ public:
         add("Momodi Modi", stars, 7, 5, 5, 3); // #28
         add("Baderon Tenfingers", stars, 3, 7, 5, 5); // #29
         add("Mother Miounne", stars, 5, 5, 3, 7); // #30
-        add("Livia sas Junius", stars, 3, 7, 7, 1); // #31
-        add("Rhitahtyn sas Arvina", stars, 7, 1, 3, 7); // #32
-        add("Biggs & Wedge", stars, 5, 3, 7, 5); // #33
+        add("Livia sas Junius", stars, 3, 7, 7, 1, GARLEAN); // #31
+        add("Rhitahtyn sas Arvina", stars, 7, 1, 3, 7, GARLEAN); // #32
+        add("Biggs & Wedge", stars, 5, 3, 7, 5, GARLEAN); // #33
         add("Gerolt", stars, 1, 7, 3, 7); // #34
         add("Frixio", stars, 6, 2, 6, 6); // #35
         add("Mutamix Bubblypots", stars, 2, 6, 6, 6); // #36
         add("Memeroon", stars, 6, 6, 6, 2); // #37
-        add("Vanu Vanu", stars, 2, 6, 4, 7); // #82
-        add("Gnath", stars, 6, 3, 7, 3); // #83
+        add("Vanu Vanu", stars, 2, 6, 4, 7, BEASTMAN); // #82
+        add("Gnath", stars, 6, 3, 7, 3, BEASTMAN); // #83
         add("Yugiri Mistwalker", stars, 7, 7, 1, 3); // #84
         add("Fat Chocobo", stars, 5, 5, 5, 5); // #85
         add("Archaeornis", stars, 5, 4, 6, 5); // #102
@@ -127,14 +130,14 @@ public:
         add("Carvallain de Gorgagne", stars, 2, 7, 7, 2); // #145
         add("Liquid Flame", stars, 4, 3, 6, 6); // #157
         add("Lost Lamb", stars, 7, 3, 4, 5); // #158
-        add("Delivery Moogle", stars, 5, 5, 6, 3); // #159
-        add("Magitek Colossus", stars, 6, 3, 6, 3); // #160
+        add("Delivery Moogle", stars, 5, 5, 6, 3, BEASTMAN); // #159
+        add("Magitek Colossus", stars, 6, 3, 6, 3, GARLEAN); // #160
         add("Adamantoise", stars, 5, 7, 4, 4); // #170
-        add("Magitek Vanguard", stars, 3, 5, 4, 7); // #171
-        add("Magitek Gunship", stars, 3, 5, 5, 5); // #172
+        add("Magitek Vanguard", stars, 3, 5, 4, 7, GARLEAN); // #171
+        add("Magitek Gunship", stars, 3, 5, 5, 5, GARLEAN); // #172
         add("Gold Saucer Attendant", stars, 4, 7, 1, 6); // #173
-        add("Kojin", stars, 4, 5, 5, 4); // #184    
-        add("Ananta", stars, 3, 7, 5, 2); // #185   
+        add("Kojin", stars, 4, 5, 5, 4, BEASTMAN); // #184    
+        add("Ananta", stars, 3, 7, 5, 2, BEASTMAN); // #185   
         add("Mnaago", stars, 4, 1, 4, 7); // #186   
         add("Kotokaze", stars, 5, 6, 2, 6); // #187
         add("Chapuli", stars, 7, 2, 2, 6); // #204   
@@ -166,7 +169,7 @@ public:
         add("Outrunner", stars, 5, 3, 6, 5); // #397
         add("Overseer Kanilokka", stars, 6, 4, 5, 4); // #411
 		add("Keeper of the Keys", stars, 5, 4, 4, 7); // #317
-		add("Loporrit", stars, 4, 6, 6, 4); // #331 
+		add("Loporrit", stars, 4, 6, 6, 4, BEASTMAN); // #331 
 		add("Argos", stars, 7, 3, 7, 1); // #332 
 		add("Gajasura", stars, 4, 7, 4, 4); // #349
 		add("Geryon the Steer", stars, 2, 4, 6, 6); // #358   
@@ -190,17 +193,17 @@ public:
         stars = 3;
         add("Behemoth", stars, 7, 8, 4, 2); // #38
         add("Gilgamesh & Enkidu", stars, 8, 3, 7, 3); // #39
-        add("Ifrit", stars, 7, 1, 6, 7); // #40
-        add("Titan", stars, 1, 7, 7, 6); // #41
-        add("Garuda", stars, 7, 6, 1, 7); // #42
-        add("Good King Moggle Mog XII", stars, 7, 6, 7, 1); // #43
+        add("Ifrit", stars, 7, 1, 6, 7, PRIMAL); // #40
+        add("Titan", stars, 1, 7, 7, 6, PRIMAL); // #41
+        add("Garuda", stars, 7, 6, 1, 7, PRIMAL); // #42
+        add("Good King Moggle Mog XII", stars, 7, 6, 7, 1, PRIMAL); // #43
         add("Raya-O-Senna & A-Ruhn-Senna", stars, 5, 6, 6, 6); // #44
         add("Godbert Manderville", stars, 6, 6, 5, 6); // #45
-        add("Thancred", stars, 2, 3, 8, 7); // #46
-        add("Nero tol Scaeva", stars, 4, 1, 8, 7); // #47
-        add("Papalymo & Yda", stars, 3, 7, 8, 2); // #48
-        add("Yshtola", stars, 7, 8, 1, 4); // #49
-        add("Urianger", stars, 8, 1, 4, 7); // #50
+        add("Thancred", stars, 2, 3, 8, 7, SCION); // #46
+        add("Nero tol Scaeva", stars, 4, 1, 8, 7, GARLEAN); // #47
+        add("Papalymo & Yda", stars, 3, 7, 8, 2, SCION); // #48
+        add("Yshtola", stars, 7, 8, 1, 4, SCION); // #49
+        add("Urianger", stars, 8, 1, 4, 7, SCION); // #50
         add("Griffin", stars, 5, 1, 7, 8); // #86
         add("Tioman", stars, 1, 5, 8, 7); // #87
         add("Estinien", stars, 8, 8, 2, 3); // #88
@@ -218,7 +221,7 @@ public:
         add("Echidna", stars, 6, 4, 7, 4); // #112
         add("Pipin Tarupin", stars, 6, 5, 6, 6); // #113
         add("Julyan Manderville", stars, 6, 6, 5, 7); // #114
-        add("Moglin", stars, 8, 5, 4, 5); // #115
+        add("Moglin", stars, 8, 5, 4, 5, BEASTMAN); // #115
         add("Charibert", stars, 7, 8, 4, 3); // #116
         add("Roundrox", stars, 2, 2, 8, 8); // #117
         add("Brachiosaur", stars, 8, 4, 5, 4); // #123
@@ -239,27 +242,27 @@ public:
         add("Mistbeard", stars, 5, 6, 7, 6); // #149
         add("Strix", stars, 5, 7, 1, 7); // #161
         add("Tozol Huatotl", stars, 7, 6, 6, 2); // #162
-        add("Alexander Prime", stars, 7, 3, 2, 8); // #163
+        add("Alexander Prime", stars, 7, 3, 2, 8, PRIMAL); // #163
         add("Brendt, Brennan, & Bremondt", stars, 4, 7, 6, 5); // #164
         add("Lava Scorpion", stars, 3, 8, 5, 5); // #174
-        add("Magitek Predator", stars, 5, 7, 4, 5); // #175
-        add("Magitek Sky Armor", stars, 6, 2, 6, 7); // #176
+        add("Magitek Predator", stars, 5, 7, 4, 5, GARLEAN); // #175
+        add("Magitek Sky Armor", stars, 6, 2, 6, 7, GARLEAN); // #176
         add("The Griffin", stars, 8, 8, 4, 1); // #177
         add("Roland", stars, 2, 7, 8, 3); // #178
         add("Mammoth", stars, 6, 3, 8, 3); // #188 
         add("Phoebad", stars, 8, 8, 3, 1); // #189  
-        add("Susano", stars, 2, 8, 3, 8); // #190   
-        add("Lakshmi", stars, 3, 7, 7, 5); // #191  
-        add("Grynewaht", stars, 7, 4, 7, 4); // #192 
+        add("Susano", stars, 2, 8, 3, 8, PRIMAL); // #190   
+        add("Lakshmi", stars, 3, 7, 7, 5, PRIMAL); // #191  
+        add("Grynewaht", stars, 7, 4, 7, 4, GARLEAN); // #192 
         add("Rasho", stars, 4, 7, 8, 2); // #193    
         add("Cirina", stars, 3, 5, 6, 8); // #194   
         add("Magnai", stars, 6, 7, 4, 4); // #195   
         add("Sadu", stars, 6, 6, 7, 4); // #196
         add("Hrodric Poisontongue", stars, 2, 7, 6, 7); // #206
-        add("Fordola rem Lupis", stars, 5, 8, 6, 3); // #207
+        add("Fordola rem Lupis", stars, 5, 8, 6, 3, GARLEAN); // #207
         add("Rofocale", stars, 4, 7, 1, 8); // #208
-        add("Genbu", stars, 7, 7, 1, 7); // #215     
-        add("Byakko", stars, 7, 1, 7, 7); // #216     
+        add("Genbu", stars, 7, 7, 1, 7, PRIMAL); // #215     
+        add("Byakko", stars, 7, 1, 7, 7, PRIMAL); // #216     
         add("Arenvald Lentinus", stars, 8, 4, 8, 2); // #217   
         add("Lupin", stars, 3, 3, 8, 7); // #218
         add("Qitian Dasheng", stars, 3, 8, 4, 8); // #224
@@ -268,16 +271,16 @@ public:
         add("Louhi", stars, 5, 8, 2, 7); // #227
         add("Tokkapchi", stars, 2, 6, 6, 7); // #233    
         add("Mist Dragon", stars, 5, 8, 5, 5); // #234    
-        add("Suzaku", stars, 1, 7, 7, 7); // #235        
-        add("Asahi sas Brutus", stars, 8, 4, 1, 8); // #238
+        add("Suzaku", stars, 1, 7, 7, 7, PRIMAL); // #235        
+        add("Asahi sas Brutus", stars, 8, 4, 1, 8, GARLEAN); // #238
         add("Pazuzu", stars, 4, 8, 4, 7); // #236     
         add("Penthesilea", stars, 7, 2, 8, 5); // #237 
         add("Prometheus", stars, 6, 5, 8, 3); // #244      
-        add("Seiryu", stars, 7, 7, 7, 1); // #246   
+        add("Seiryu", stars, 7, 7, 7, 1, PRIMAL); // #246   
         add("Alpha", stars, 6, 6, 6, 6); // #247
         add("Provenance Watcher", stars, 7, 4, 4, 8); // #245
         add("Philia", stars, 2, 6, 8, 6); // #260   
-        add("Titania", stars, 8, 6, 6, 2); // #261     
+        add("Titania", stars, 8, 6, 6, 2, PRIMAL); // #261     
         add("Eros", stars, 6, 2, 6, 8); // #262   
         add("Storge", stars, 6, 8, 2, 6); // #263   
         add("Formidable", stars, 8, 5, 5, 5); // #264    
@@ -303,9 +306,9 @@ public:
 		add("Azulmagia", stars, 4, 8, 6, 6); // #309    
 		add("Siegfried", stars, 6, 6, 4, 8); // #310    
 		add("Gogo, Master of Mimicry", stars, 8, 6, 4, 6); // #311
-		add("Lunar Bahamut", stars, 8, 2, 8, 4); // #318      
-		add("Valens van Varro", stars, 7, 5, 8, 3); // #319
-		add("Lunar Ifrit", stars, 8, 3, 4, 7); // #320      
+		add("Lunar Bahamut", stars, 8, 2, 8, 4, PRIMAL); // #318      
+		add("Valens van Varro", stars, 7, 5, 8, 3, GARLEAN); // #319
+		add("Lunar Ifrit", stars, 8, 3, 4, 7, PRIMAL); // #320      
 		add("4th-make Shemhazai", stars, 1, 6, 7, 8); // #321   
 		add("4th-make Cuchulainn", stars, 8, 1, 7, 6); // #322
 		add("Hermes", stars, 6, 8, 7, 1); // #333      
@@ -345,53 +348,53 @@ public:
 
         // ______ 4-STAR CARDS _______
         stars = 4;
-        add("Ultima Weapon", stars, 7, 8, 9, 1); // #51
-        add("Odin", stars, 8, 8, 1, 8); // #52
-        add("Ramuh", stars, 8, 1, 8, 8); // #53
-        add("Leviathan", stars, 8, 8, 8, 1); // #54
-        add("Shiva", stars, 1, 8, 8, 8); // #55
-        add("Minfilia", stars, 9, 8, 3, 5); // #56
+        add("Ultima Weapon", stars, 7, 8, 9, 1, GARLEAN); // #51
+        add("Odin", stars, 8, 8, 1, 8, PRIMAL); // #52
+        add("Ramuh", stars, 8, 1, 8, 8, PRIMAL); // #53
+        add("Leviathan", stars, 8, 8, 8, 1, PRIMAL); // #54
+        add("Shiva", stars, 1, 8, 8, 8, PRIMAL); // #55
+        add("Minfilia", stars, 9, 8, 3, 5, SCION); // #56
         add("Lahabrea", stars, 4, 9, 4, 8); // #57
-        add("Cid Garlond", stars, 5, 9, 9, 2); // #58
-        add("Alphinaud & Alisaie", stars, 9, 3, 3, 9); // #59
-        add("Louisoix Leveilleur", stars, 9, 4, 9, 3); // #60
+        add("Cid Garlond", stars, 5, 9, 9, 2, GARLEAN); // #58
+        add("Alphinaud & Alisaie", stars, 9, 3, 3, 9, SCION); // #59
+        add("Louisoix Leveilleur", stars, 9, 4, 9, 3, SCION); // #60
         add("Aymeric", stars, 1, 5, 9, 9); // #96
-        add("Ravana", stars, 9, 7, 8, 1); // #97
-        add("Bismarck", stars, 1, 9, 7, 8); // #98
+        add("Ravana", stars, 9, 7, 8, 1, PRIMAL); // #97
+        add("Bismarck", stars, 1, 9, 7, 8, PRIMAL); // #98
         add("Senor Sabotender", stars, 9, 5, 7, 6); // #118
         add("Xande", stars, 9, 4, 6, 7); // #135
         add("Brute Justice", stars, 7, 7, 7, 7); // #136
-        add("Sephirot", stars, 6, 8, 8, 6); // #137
+        add("Sephirot", stars, 6, 8, 8, 6, PRIMAL); // #137
         add("Flhaminn", stars, 9, 7, 3, 7); // #138
         add("Vidofnir", stars, 8, 6, 8, 6); // #139
         add("Unei & Doga", stars, 6, 8, 6, 8); // #150
         add("Tiamat", stars, 9, 6, 5, 6); // #151
         add("Calofisteri", stars, 5, 8, 7, 8); // #152
-        add("Heavensward Thancred", stars, 8, 1, 7, 9); // #165
-        add("Heavensward Yshtola", stars, 9, 9, 2, 5); // #166
-        add("Nael van Darnus", stars, 3, 9, 3, 9); // #167
+        add("Heavensward Thancred", stars, 8, 1, 7, 9, SCION); // #165
+        add("Heavensward Yshtola", stars, 9, 9, 2, 5, SCION); // #166
+        add("Nael van Darnus", stars, 3, 9, 3, 9, GARLEAN); // #167
         add("Diabolos Hollow", stars, 4, 4, 8, 9); // #179
-        add("Armored Weapon", stars, 3, 5, 9, 7); // #180
+        add("Armored Weapon", stars, 3, 5, 9, 7, GARLEAN); // #180
         add("Gigi", stars, 6, 8, 4, 7); // #181
-        add("Shinryu", stars, 7, 8, 8, 2); // #197 
+        add("Shinryu", stars, 7, 8, 8, 2, PRIMAL); // #197 
         add("Yotsuyu", stars, 9, 2, 8, 6); // #198  
-        add("Krile", stars, 2, 8, 8, 7); // #199    
-        add("Lyse", stars, 6, 9, 1, 8); // #200   
+        add("Krile", stars, 2, 8, 8, 7, SCION); // #199    
+        add("Lyse", stars, 6, 9, 1, 8, SCION); // #200   
         add("Argath Thadalfus", stars, 9, 2, 5, 8); // #209 
         add("Hancock", stars, 8, 9, 1, 7); // #219
-        add("Tsukuyomi", stars, 2, 7, 7, 8); // #228
+        add("Tsukuyomi", stars, 2, 7, 7, 8, PRIMAL); // #228
         add("Great Gold Whisker", stars, 6, 9, 6, 7); // #248
         add("Stormblood Gilgamesh", stars, 9, 4, 8, 4); // #249
-        add("Innocence", stars, 8, 3, 8, 8); // #267     
-        add("Shadowbringers Yshtola", stars, 2, 9, 5, 9); // #268  
-        add("Shadowbringers Urianger", stars, 9, 2, 5, 9); // #269   
+        add("Innocence", stars, 8, 3, 8, 8, PRIMAL); // #267     
+        add("Shadowbringers Yshtola", stars, 2, 9, 5, 9, SCION); // #268  
+        add("Shadowbringers Urianger", stars, 9, 2, 5, 9, SCION); // #269   
         add("Ranjit", stars, 1, 9, 9, 5); // #270
         add("Oracle of Light", stars, 7, 7, 9, 4); // #280
-        add("Ruby Weapon", stars, 8, 7, 1, 9); // #291
+        add("Ruby Weapon", stars, 8, 7, 1, 9, GARLEAN); // #291
         add("Elidibus", stars, 8, 4, 9, 4); // #300   
-        add("Shadowbringers Thancred", stars, 7, 9, 8, 1); // #301  
-        add("Sapphire Weapon", stars, 1, 9, 8, 7); // #302
-        add("Emerald Weapon", stars, 7, 1, 9, 8); // #312   
+        add("Shadowbringers Thancred", stars, 7, 9, 8, 1, SCION); // #301  
+        add("Sapphire Weapon", stars, 1, 9, 8, 7, GARLEAN); // #302
+        add("Emerald Weapon", stars, 7, 1, 9, 8, GARLEAN); // #312   
         add("Ryne", stars, 7, 9, 7, 1); // #313        
         add("Gaia", stars, 5, 9, 1, 9); // #314 
         add("Cahciua", stars, 8, 8, 5, 5); // #416
@@ -399,20 +402,20 @@ public:
         add("Mica the Magical Mu", stars, 8, 2, 9, 6); // #418
         add("Prishe of the Distant Chains", stars, 6, 8, 8, 5); // #419
 		add("G-Warrior", stars, 9, 1, 7, 8); // #323        
-		add("Diamond Weapon", stars, 9, 8, 7, 1); // #324   
+		add("Diamond Weapon", stars, 9, 8, 7, 1, GARLEAN); // #324   
 		add("Diablo Armament", stars, 4, 4, 9, 9); // #325     
 		add("Anima", stars, 5, 1, 9, 9); // #339         
-		add("Quintus van Cinna", stars, 9, 3, 6, 8); // #340   
-		add("Endwalker Alphinaud & Alisaie", stars, 4, 9, 9, 3); // #341    
+		add("Quintus van Cinna", stars, 9, 3, 6, 8, GARLEAN); // #340   
+		add("Endwalker Alphinaud & Alisaie", stars, 4, 9, 9, 3, SCION); // #341    
 		add("Hythlodaeus", stars, 7, 9, 6, 6); // #342     
 		add("Vrtra", stars, 9, 3, 7, 7); // #343     
 		add("Chi", stars, 8, 1, 9, 7); // #354           
 		add("Daivadipa", stars, 7, 8, 1, 9); // #355     
-		add("Scarmiglione", stars, 7, 6, 8, 7); // #364  
-		add("Barbariccia", stars, 6, 7, 7, 8); // #365   
+		add("Scarmiglione", stars, 7, 6, 8, 7, PRIMAL); // #364  
+		add("Barbariccia", stars, 6, 7, 7, 8, PRIMAL); // #365   
 		add("Chief Keyward Lahabrea", stars, 5, 9, 5, 8); // #366   
-		add("Cagnazzo", stars, 8, 6, 7, 7); // #375      
-		add("Rubicante", stars, 7, 8, 6, 7); // #376    
+		add("Cagnazzo", stars, 8, 6, 7, 7, PRIMAL); // #375      
+		add("Rubicante", stars, 7, 8, 6, 7, PRIMAL); // #376    
 		add("Themis", stars, 5, 5, 9, 8); // #385       
 		add("Enenra", stars, 8, 5, 5, 9); // #386      
 		add("Eulogia", stars, 6, 9, 6, 7); // #402     
@@ -425,22 +428,22 @@ public:
 
         // ______ 5-STAR CARDS _______
         stars = 5;
-        add("Bahamut", stars, 9, 5, 9, 6); // #61
+        add("Bahamut", stars, 9, 5, 9, 6, PRIMAL); // #61
         add("Hildibrand & Nashu Mhakaracca", stars, 1, 8, STRENGTH_MAX, 8); // #62
         add("Nanamo UI Namo", stars, STRENGTH_MAX, 6, 4, 8); // #63
-        add("Gaius van Baelsar", stars, 4, STRENGTH_MAX, 5, 9); // #64
+        add("Gaius van Baelsar", stars, 4, STRENGTH_MAX, 5, 9, GARLEAN); // #64
         add("Merlwyb Bloefhiswyn", stars, 5, 9, STRENGTH_MAX, 3); // #65
         add("Kan-E-Senna", stars, 9, STRENGTH_MAX, 1, 7); // #66
         add("Raubahn Aldynn", stars, 6, 2, 9, STRENGTH_MAX); // #67
         add("Nidhogg", stars, STRENGTH_MAX, 7, 3, 8); // #99
         add("Midgardsormr", stars, 3, 8, STRENGTH_MAX, 7); // #100
-        add("Regula van Hydrus", stars, 8, 8, 3, 8); // #119
+        add("Regula van Hydrus", stars, 8, 8, 3, 8, GARLEAN); // #119
         add("Archbishop Thordan VII", stars, 7, 1, STRENGTH_MAX, 9); // #120
         add("Cloud of Darkness", stars, 7, STRENGTH_MAX, 3, 8); // #140
         add("Hraesvelgr", stars, 7, 7, STRENGTH_MAX, 6); // #153
         add("Sophia", stars, STRENGTH_MAX, 8, 5, 6); // #168
         add("Zurvan", stars, 3, 7, 8, STRENGTH_MAX); // #182
-        add("Zenos yae Galvus", stars, 6, 6, 7, STRENGTH_MAX); // #201 
+        add("Zenos yae Galvus", stars, 6, 6, 7, STRENGTH_MAX, GARLEAN); // #201 
         add("Hien", stars, 2, STRENGTH_MAX, 5, STRENGTH_MAX); // #202   
         add("Raubahn & Pipin", stars, 1, STRENGTH_MAX, STRENGTH_MAX, 6); // #210
         add("Hisui & Kurenai", stars, STRENGTH_MAX, 2, 7, 9); // #220
@@ -449,13 +452,13 @@ public:
         add("Omega", stars, 6, 9, 3, STRENGTH_MAX); // #240
         add("Yojimbo & Daigoro", stars, STRENGTH_MAX, 8, 1, 8); // #239
         add("Ultima, the High Seraph", stars, 6, STRENGTH_MAX, 7, 7); // #250
-        add("Stormblood Alphinaud & Alisaie", stars, 6, 8, 8, 8); // #251 
+        add("Stormblood Alphinaud & Alisaie", stars, 6, 8, 8, 8, SCION); // #251 
         add("Hades", stars, 8, 6, 6, STRENGTH_MAX); // #271   
         add("Ardbert", stars, 1, 9, 9, 9); // #272
         add("Archaeotania", stars, STRENGTH_MAX, 9, 7, 1); // #281 
         add("9S", stars, 4, 8, 6, STRENGTH_MAX); // #282 
         add("Therion", stars, 9, 9, 2, 9); // #292
-        add("Varis yae Galvus", stars, STRENGTH_MAX, STRENGTH_MAX, 4, 1); // #293 
+        add("Varis yae Galvus", stars, STRENGTH_MAX, STRENGTH_MAX, 4, 1, GARLEAN); // #293 
         add("2P", stars, 4, 8, STRENGTH_MAX, 6); // #303    5 Star
         add("Shadowbringers Warrior of Light", stars, 2, STRENGTH_MAX, STRENGTH_MAX, 5); // #304
         add("Edens Promise", stars, STRENGTH_MAX, 5, 8, 6); // #315   
@@ -469,9 +472,9 @@ public:
         add("Noctis Lucis Caelum", stars, 7, STRENGTH_MAX, 9, 1); // #434
         add("Clive Rosfield", stars, STRENGTH_MAX, 7, 8, 5); // #435
 		add("2B", stars, 6, STRENGTH_MAX, 4, 8); // #326     
-		add("Zodiark", stars, 5, STRENGTH_MAX, 3, STRENGTH_MAX); // #344     
-		add("Hydaelyn", stars, STRENGTH_MAX, 3, STRENGTH_MAX, 5); // #345   
-		add("Zenos Galvus", stars, 6, 6, 9, 9); // #346     
+		add("Zodiark", stars, 5, STRENGTH_MAX, 3, STRENGTH_MAX, PRIMAL); // #344     
+		add("Hydaelyn", stars, STRENGTH_MAX, 3, STRENGTH_MAX, 5, PRIMAL); // #345   
+		add("Zenos Galvus", stars, 6, 6, 9, 9, GARLEAN); // #346     
 		add("Endsinger", stars, 7, STRENGTH_MAX, 2, 9); // #356    
 		add("Hephaistos", stars, 9, 4, STRENGTH_MAX, 5); // #367     
 		add("Venat", stars, 4, 8, 7, STRENGTH_MAX); // #377   
@@ -496,19 +499,20 @@ public:
         return cards.front(); // The first element of cards is an empty card
     }
 
-    static ID randomID() {
-        return 1 + std::rand() % (cards.size() - 1);
+    static ID randomID(Random::Generator& rng) {
+        return 1 + ID(rng.below(cards.size() - 1));
     }
 
-    static Card random() {
-        return cards[randomID()];
+    static Card random(Random::Generator& rng) {
+        return cards[randomID(rng)];
     }
 
-    static ID randomWithStarsID(const int numStars) {
-        Card starCard = random();
-        while (starCard.stars() != numStars)
-            starCard = random();
-        return starCard.id();
+    static const std::vector<ID>& withStars(const int numStars) {
+        return byStars[numStars];
+    }
+
+    static ID randomWithStarsID(const int numStars, Random::Generator& rng) {
+        return byStars[numStars][rng.below(byStars[numStars].size())];
     }
 
     static std::string name(const ID id) {
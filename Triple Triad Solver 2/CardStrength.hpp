@@ -0,0 +1,257 @@
+#pragma once
+#include "defs.hpp"
+#include "MatchRecord.hpp"
+#include "DeckStore.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* Per-card strengths fitted straight from game outcomes. A deck's strength is the sum of its
+five cards' strengths, and RED's expected score is the logistic function of RED's strength
+minus BLUE's, so each card is credited only for what it adds beyond its deck-mates. Draws
+count as half a point. The fit minimises the log loss plus an L2 penalty, which pulls cards
+with few games towards 0. With only a few hundred cards the full Newton step is cheap, so
+each iteration is one parallel pass over the games building the gradient and Hessian, a
+Cholesky solve, then a lighter loss-only pass to check the step; it converges in a handful
+of iterations. Sums run over fixed deck ranges in order, so the fit is identical for any
+thread count. The fit is kept until more games come in. Strengths are reported in ELO
+points per card */
+namespace CardStrength {
+    static constexpr double L2_PENALTY = 1.0;
+    static constexpr double TOLERANCE = 0.01;   // Largest strength step, in ELO points, once converged
+    static constexpr int MAX_ITERATIONS = 50;
+    static constexpr int HESSIAN_BLOCKS = 16;   // Deck ranges with their own Hessian sums, shared out between threads
+    static constexpr uint64_t LOG_BATCH = 256;  // Each factor is at most 2, so a batch stays below 2^256
+
+    static std::vector<double> strengths;   // Per card ID, in logits
+    static std::vector<int> deckCounts;     // Decks with games holding each card; 0 means no estimate
+
+    static double strength(ID card) {
+        return card < ID(strengths.size()) ? ELO_PER_LOGIT * strengths[card] : 0.0;
+    }
+
+    // Solves A x = b in place for symmetric positive definite A (n x n, row-major), which it overwrites
+    static void solveCholesky(std::vector<double>& a, int n, std::vector<double>& b) {
+        for (int j = 0; j < n; j++) {
+            double diagonal = a[size_t(j) * n + j];
+            for (int k = 0; k < j; k++)
+                diagonal -= a[size_t(j) * n + k] * a[size_t(j) * n + k];
+            diagonal = std::sqrt(diagonal);
+            a[size_t(j) * n + j] = diagonal;
+            for (int i = j + 1; i < n; i++) {
+                double value = a[size_t(i) * n + j];
+                for (int k = 0; k < j; k++)
+                    value -= a[size_t(i) * n + k] * a[size_t(j) * n + k];
+                a[size_t(i) * n + j] = value / diagonal;
+            }
+        }
+        for (int i = 0; i < n; i++) { // L y = b
+            for (int k = 0; k < i; k++)
+                b[i] -= a[size_t(i) * n + k] * b[k];
+            b[i] /= a[size_t(i) * n + i];
+        }
+        for (int i = n - 1; i >= 0; i--) { // L^T x = y
+            for (int k = i + 1; k < n; k++)
+                b[i] -= a[size_t(k) * n + i] * b[k];
+            b[i] /= a[size_t(i) * n + i];
+        }
+    }
+
+    static uint64_t fittedGames = UINT64_MAX;   // Games the current strengths were fitted to
+    static uint64_t fittedDecks = 0;
+
+    // Forgets the fit, for when recorded games are cleared
+    static void clear() {
+        strengths.clear();
+        deckCounts.clear();
+        fittedGames = UINT64_MAX;
+    }
+
+    /* Fits strengths to games. Games are only ever appended until clear(), so a fit to as
+    many games and decks as last time is still current and returns at once */
+    static void fit(const std::vector<GameResult>& games, const DeckStore& decks, int cardCount,
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency())) {
+        if (games.size() == fittedGames && decks.size() == fittedDecks && strengths.size() == size_t(cardCount))
+            return;
+        const auto start = std::chrono::steady_clock::now();
+        const int deckCount = int(decks.size());
+
+        // Each deck's games from its own side: the opponent and the points scored
+        struct Entry {
+            uint32_t opponent;
+            float points;
+        };
+        std::vector<uint64_t> offsets(size_t(deckCount) + 1, 0);
+        for (const GameResult& game : games) {
+            offsets[game.redDeck + 1]++;
+            offsets[game.blueDeck + 1]++;
+        }
+        for (int deck = 0; deck < deckCount; deck++)
+            offsets[deck + 1] += offsets[deck];
+        std::vector<Entry> entries(offsets[deckCount]);
+        {
+            std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+            for (const GameResult& game : games) {
+                entries[next[game.redDeck]++] = { game.blueDeck, 0.5f * game.redHalfPoints };
+                entries[next[game.blueDeck]++] = { game.redDeck, 0.5f * (2 - game.redHalfPoints) };
+            }
+        }
+
+        deckCounts.assign(cardCount, 0);
+        for (ID deck = 0; deck < deckCount; deck++)
+            if (offsets[deck + 1] > offsets[deck])
+                for (int slot = 0; slot < DECK_SIZE; slot++)
+                    deckCounts[decks.card(deck, slot)]++;
+
+        // Starts from the last fit, so a report after a few more games takes an iteration or two
+        std::vector<double> theta = strengths.size() == size_t(cardCount) ? strengths : std::vector<double>(cardCount, 0.0);
+        std::vector<double> trial(cardCount), deckStrength(deckCount), deckLoss(deckCount), deckGradient(deckCount);
+        std::vector<std::vector<double>> blockHessians(HESSIAN_BLOCKS);
+        std::vector<double> hessian(size_t(cardCount) * cardCount);
+
+        // Log loss of strengths, leaving deckStrength set for derivatives()
+        const auto lossOf = [&](const std::vector<double>& card) {
+            for (ID deck = 0; deck < deckCount; deck++) {
+                double sum = 0.0;
+                for (int slot = 0; slot < DECK_SIZE; slot++)
+                    sum += card[decks.card(deck, slot)];
+                deckStrength[deck] = sum;
+            }
+            parallelRanges(deckCount, threads, [&](int first, int last, unsigned int) {
+                for (ID deck = first; deck < last; deck++) {
+                    // log(1 + e^-|margin|) terms are multiplied up and logged LOG_BATCH at a time, which stays far from overflow
+                    double loss = 0.0, product = 1.0;
+                    for (uint64_t k = offsets[deck]; k < offsets[deck + 1]; k++) {
+                        const double margin = deckStrength[deck] - deckStrength[entries[k].opponent];
+                        product *= 1.0 + std::exp(-std::abs(margin));
+                        loss += std::max(-margin, 0.0) + (1.0 - entries[k].points) * margin;
+                        if ((k - offsets[deck]) % LOG_BATCH == LOG_BATCH - 1) {
+                            loss += std::log(product);
+                            product = 1.0;
+                        }
+                    }
+                    deckLoss[deck] = 0.5 * (loss + std::log(product)); // Every game is seen from both sides
+                }
+            });
+            double total = 0.0;
+            for (ID deck = 0; deck < deckCount; deck++)
+                total += deckLoss[deck];
+            for (const double value : card)
+                total += 0.5 * L2_PENALTY * value * value;
+            return total;
+        };
+
+        /* Gradient and Hessian of the loss at the strengths lossOf() last saw. The Hessian over
+        cards sums curvature x_d x_d^T over decks, minus each game's weight times x_d x_o^T from
+        both sides, x being the deck's 5-hot card vector */
+        std::vector<double> gradient(cardCount), step(cardCount);
+        const auto derivatives = [&](const std::vector<double>& card) {
+            parallelRanges(HESSIAN_BLOCKS, threads, [&](int firstBlock, int lastBlock, unsigned int) {
+                std::vector<double> opponentWeight(cardCount, 0.0);
+                std::vector<bool> isTouched(cardCount, false);
+                std::vector<ID> touched;    // Cards faced in the deck's games
+                for (int block = firstBlock; block < lastBlock; block++) {
+                    std::vector<double>& partial = blockHessians[block];
+                    partial.assign(size_t(cardCount) * cardCount, 0.0);
+                    const ID first = ID(uint64_t(deckCount) * block / HESSIAN_BLOCKS);
+                    const ID last = ID(uint64_t(deckCount) * (block + 1) / HESSIAN_BLOCKS);
+                    for (ID deck = first; deck < last; deck++) {
+                        double gradientSum = 0.0, curvature = 0.0;
+                        for (uint64_t k = offsets[deck]; k < offsets[deck + 1]; k++) {
+                            const double expected = 1.0 / (1.0 + std::exp(deckStrength[entries[k].opponent] - deckStrength[deck]));
+                            const double weight = expected * (1.0 - expected);
+                            gradientSum += expected - entries[k].points;
+                            curvature += weight;
+                            for (int slot = 0; slot < DECK_SIZE; slot++) {
+                                const ID other = decks.card(entries[k].opponent, slot);
+                                if (!isTouched[other]) {
+                                    isTouched[other] = true;
+                                    touched.push_back(other);
+                                }
+                                opponentWeight[other] += weight;
+                            }
+                        }
+                        deckGradient[deck] = gradientSum;
+                        for (int a = 0; a < DECK_SIZE; a++) {
+                            double* row = &partial[size_t(decks.card(deck, a)) * cardCount];
+                            for (int b = 0; b < DECK_SIZE; b++)
+                                row[decks.card(deck, b)] += curvature;
+                            for (const ID other : touched) // Summed over the deck's games first
+                                row[other] -= opponentWeight[other];
+                        }
+                        for (const ID other : touched) {
+                            opponentWeight[other] = 0.0;
+                            isTouched[other] = false;
+                        }
+                        touched.clear();
+                    }
+                }
+            });
+            std::fill(hessian.begin(), hessian.end(), 0.0);
+            for (const std::vector<double>& partial : blockHessians) // In block order, whatever the thread count
+                for (size_t i = 0; i < hessian.size(); i++)
+                    hessian[i] += partial[i];
+            for (int c = 0; c < cardCount; c++) {
+                gradient[c] = L2_PENALTY * card[c];
+                hessian[size_t(c) * cardCount + c] += L2_PENALTY;
+            }
+            for (ID deck = 0; deck < deckCount; deck++)
+                for (int slot = 0; slot < DECK_SIZE; slot++)
+                    gradient[decks.card(deck, slot)] += deckGradient[deck];
+        };
+
+        // Line search trials only need the loss; the Hessian is built once per accepted step
+        int iterations = 0;
+        double loss = lossOf(theta);
+        for (iterations = 1; iterations <= MAX_ITERATIONS; iterations++) {
+            derivatives(theta);
+            for (int card = 0; card < cardCount; card++)
+                step[card] = -gradient[card];
+            solveCholesky(hessian, cardCount, step);
+
+            // Halves the Newton step until the loss falls, which it almost always does at once
+            double scale = 1.0, largest = 0.0, trialLoss = loss;
+            for (int halvings = 0; halvings < 30; halvings++, scale *= 0.5) {
+                largest = 0.0;
+                for (int card = 0; card < cardCount; card++) {
+                    trial[card] = theta[card] + scale * step[card];
+                    largest = std::max(largest, std::abs(scale * step[card]));
+                }
+                trialLoss = lossOf(trial);
+                if (trialLoss <= loss)
+                    break;
+            }
+            if (trialLoss > loss)
+                break; // No step helps: at the optimum to rounding
+            theta.swap(trial);
+            loss = trialLoss;
+            if (ELO_PER_LOGIT * largest < TOLERANCE)
+                break;
+        }
+        strengths.swap(theta);
+        fittedGames = games.size();
+        fittedDecks = decks.size();
+
+        std::cout << "CardStrength: " << games.size() << " games, " << std::min(iterations, MAX_ITERATIONS)
+            << " iterations, log loss " << loss / std::max<size_t>(games.size(), 1) << " per game, "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+    }
+
+    // Cards with an estimate, strongest first when descending, with their strengths in ELO points
+    static std::vector<std::pair<ID, double>> ranked(bool descending) {
+        std::vector<std::pair<ID, double>> cards;
+        for (ID card = 0; card < ID(strengths.size()); card++)
+            if (deckCounts[card] > 0)
+                cards.push_back({ card, strength(card) });
+        std::sort(cards.begin(), cards.end(), [descending](const auto& a, const auto& b) {
+            if (a.second != b.second)
+                return descending ? a.second > b.second : a.second < b.second;
+            return a.first < b.first;
+        });
+        return cards;
+    }
+}
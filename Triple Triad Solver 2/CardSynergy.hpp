@@ -0,0 +1,177 @@
+#pragma once
+#include "defs.hpp"
+#include "MatchRecord.hpp"
+#include "DeckStore.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* Wins, draws and losses of the decks holding each pair of cards, over every recorded game,
+and how far each pair beats what its two cards manage apart. The games are first reduced to
+per-deck totals, so the pair table is touched ten times per deck rather than per game: the
+pass over the games only scatters into a deck-sized table, and the pass over the decks only
+into the card-pair triangle, each small enough to stay in cache. Both passes give every thread
+its own table, merged in thread order at the end. Memory is bounded by threads times decks
+plus card pairs, however many games there are, and counts are integers, so the result is the
+same for any thread count */
+namespace CardSynergy {
+    static constexpr uint64_t GAME_BLOCK = 1 << 20;   // Games per work item in the first pass
+
+    struct Tally {
+        uint64_t wins = 0, draws = 0, losses = 0;
+        uint64_t decks = 0;     // Decks that played, holding the card or pair
+
+        uint64_t games() const {
+            return wins + draws + losses;
+        }
+
+        // Points per game, with one virtual draw so unbeaten or winless records stay finite
+        double score() const {
+            return (wins + 0.5 * draws + 0.5) / (games() + 1.0);
+        }
+
+        void add(const Tally& other) {
+            wins += other.wins;
+            draws += other.draws;
+            losses += other.losses;
+            decks += other.decks;
+        }
+    };
+
+    struct Synergy {
+        ID first, second;
+        uint64_t decks;
+        double synergy;     // In ELO points
+    };
+
+    static std::vector<Tally> pairTallies;  // Lower triangle, see pairIndex()
+    static std::vector<Tally> cardTallies;  // Per card ID
+    static int cards = 0;
+
+    // a != b
+    static size_t pairIndex(ID a, ID b) {
+        const size_t high = size_t(std::max(a, b)), low = size_t(std::min(a, b));
+        return high * (high - 1) / 2 + low;
+    }
+
+    static double logit(double p) {
+        return std::log(p / (1.0 - p));
+    }
+
+    static const Tally& tally(ID a, ID b) {
+        return pairTallies[pairIndex(a, b)];
+    }
+
+    /* The pair's score if its cards' effects just add up: every deck side scores 0.5 on
+    average, so the two cards' log-odds are added as they are */
+    static double expectedScore(ID a, ID b) {
+        const double logOdds = logit(cardTallies[a].score()) + logit(cardTallies[b].score());
+        return 1.0 / (1.0 + std::exp(-logOdds));
+    }
+
+    // How much better the pair scores than expectedScore(), in ELO points
+    static double synergy(ID a, ID b) {
+        return ELO_PER_LOGIT * (logit(tally(a, b).score()) - logit(expectedScore(a, b)));
+    }
+
+    static void compute(const std::vector<GameResult>& games, const DeckStore& decks, int cardCount,
+        unsigned int threads = std::max(1u, std::thread::hardware_concurrency())) {
+        const auto start = std::chrono::steady_clock::now();
+        const int deckCount = int(decks.size());
+        struct DeckTally {
+            uint32_t wins, draws, losses;
+        };
+
+        // Games to deck totals
+        const int gameBlocks = int((games.size() + GAME_BLOCK - 1) / GAME_BLOCK);
+        std::vector<std::vector<DeckTally>> threadDecks(threads);
+        parallelRanges(gameBlocks, threads, [&](int firstBlock, int lastBlock, unsigned int thread) {
+            std::vector<DeckTally>& local = threadDecks[thread];
+            local.assign(deckCount, DeckTally{});
+            const uint64_t last = std::min<uint64_t>(games.size(), GAME_BLOCK * lastBlock);
+            for (uint64_t k = GAME_BLOCK * firstBlock; k < last; k++) {
+                const GameResult& game = games[k];
+                switch (game.redHalfPoints) {
+                case 2:
+                    local[game.redDeck].wins++;
+                    local[game.blueDeck].losses++;
+                    break;
+                case 1:
+                    local[game.redDeck].draws++;
+                    local[game.blueDeck].draws++;
+                    break;
+                default:
+                    local[game.redDeck].losses++;
+                    local[game.blueDeck].wins++;
+                }
+            }
+        });
+        std::vector<DeckTally> deckTallies(deckCount, DeckTally{});
+        for (std::vector<DeckTally>& local : threadDecks) {
+            for (size_t deck = 0; deck < local.size(); deck++) {
+                deckTallies[deck].wins += local[deck].wins;
+                deckTallies[deck].draws += local[deck].draws;
+                deckTallies[deck].losses += local[deck].losses;
+            }
+            std::vector<DeckTally>().swap(local);
+        }
+
+        // Deck totals to card and card-pair totals
+        const size_t pairCount = cardCount > 1 ? pairIndex(cardCount - 1, 0) + cardCount - 1 : 0;
+        std::vector<std::vector<Tally>> threadPairs(threads), threadCards(threads);
+        parallelRanges(deckCount, threads, [&](int first, int last, unsigned int thread) {
+            std::vector<Tally>& localPairs = threadPairs[thread];
+            std::vector<Tally>& localCards = threadCards[thread];
+            localPairs.assign(pairCount, Tally());
+            localCards.assign(cardCount, Tally());
+            for (ID deck = first; deck < last; deck++) {
+                const DeckTally& totals = deckTallies[deck];
+                if (totals.wins + totals.draws + totals.losses == 0)
+                    continue;
+                const Tally record{ totals.wins, totals.draws, totals.losses, 1 };
+                for (int a = 0; a < DECK_SIZE; a++) {
+                    localCards[decks.card(deck, a)].add(record);
+                    for (int b = a + 1; b < DECK_SIZE; b++)
+                        localPairs[pairIndex(decks.card(deck, a), decks.card(deck, b))].add(record);
+                }
+            }
+        });
+        pairTallies.assign(pairCount, Tally());
+        cardTallies.assign(cardCount, Tally());
+        for (unsigned int thread = 0; thread < threads; thread++) {
+            for (size_t i = 0; i < threadPairs[thread].size(); i++)
+                pairTallies[i].add(threadPairs[thread][i]);
+            for (size_t i = 0; i < threadCards[thread].size(); i++)
+                cardTallies[i].add(threadCards[thread][i]);
+        }
+        cards = cardCount;
+
+        std::cout << "CardSynergy: " << games.size() << " games, " << pairCount << " card pairs, "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+    }
+
+    /* Pairs held by at least minDecks decks that have played, most synergistic first when
+    descending, or all of them when count is negative. A pair held by only a deck or two
+    mostly measures those decks' other cards, however many games they played */
+    static std::vector<Synergy> ranked(int count, uint64_t minDecks, bool descending) {
+        std::vector<Synergy> pairs;
+        for (ID a = 1; a < cards; a++)
+            for (ID b = 0; b < a; b++)
+                if (tally(a, b).decks >= std::max<uint64_t>(minDecks, 1))
+                    pairs.push_back({ b, a, tally(a, b).decks, synergy(a, b) });
+        const auto order = [descending](const Synergy& x, const Synergy& y) {
+            if (x.synergy != y.synergy)
+                return descending ? x.synergy > y.synergy : x.synergy < y.synergy;
+            return x.first != y.first ? x.first < y.first : x.second < y.second;
+        };
+        const size_t kept = count < 0 ? pairs.size() : std::min(pairs.size(), size_t(count));
+        std::partial_sort(pairs.begin(), pairs.begin() + kept, pairs.end(), order);
+        pairs.resize(kept);
+        return pairs;
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "CardCollection.hpp"
+#include "Journal.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* The card table a set of results was solved against, saved alongside them. After a patch
+the saved table is diffed with CardCollection to find the cards whose solve-relevant stats
+(edges and type) changed or that are new, so only matchups involving them are solved again.
+Cards are compared by ID: a card inserted mid-table shifts every later ID, which shows up as
+stat changes and costs re-solves, but never a wrong result */
+namespace CardTable {
+    static constexpr char MAGIC[4] = { 'T', 'T', 'C', 'T' };
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t cardCount;
+        uint32_t reserved;
+    };
+
+    struct Entry {
+        uint64_t nameHash;
+        uint8_t edges[4];
+        uint8_t type;
+        uint8_t stars;
+        uint16_t reserved;
+    };
+    static_assert(sizeof(Header) == 16 && sizeof(Entry) == 16, "Card table layout must not depend on padding");
+
+    static uint64_t nameHash(const std::string& name) {
+        uint64_t h = mix64(name.size());
+        for (const char c : name)
+            h = mix64(h ^ uint64_t(uint8_t(c)));
+        return h;
+    }
+
+    static Entry entryOf(ID id) {
+        const Card& card = CardCollection::card(id);
+        Entry entry{};
+        entry.nameHash = nameHash(CardCollection::name(id));
+        for (int edge = 0; edge < 4; edge++)
+            entry.edges[edge] = uint8_t(card.attribute(edge));
+        entry.type = uint8_t(card.type());
+        entry.stars = uint8_t(card.stars());
+        return entry;
+    }
+
+    // Replaces any earlier save whole or not at all, like PoolFile::save()
+    static bool save(const std::string& path) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.cardCount = uint32_t(CardCollection::cardCount());
+        std::vector<Entry> entries;
+        for (ID id = 0; id < CardCollection::cardCount(); id++)
+            entries.push_back(entryOf(id));
+
+        return Journal::replaceFile(path, [&](FILE* file) {
+            return std::fwrite(&header, sizeof(header), 1, file) == 1
+                && std::fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size();
+        });
+    }
+
+    static bool load(const std::string& path, std::vector<Entry>& entries) {
+        std::ifstream in(path, std::ios::binary);
+        Header header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            std::cout << "CardTable::load() " << path << " is not a card table" << std::endl;
+            return false;
+        }
+        entries.resize(header.cardCount);
+        if (!in.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(Entry))) {
+            std::cout << "CardTable::load() " << path << " is truncated" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /* Per card ID of CardCollection: whether results solved against the saved table may be
+    wrong for it. Stars only affect which decks are legal, not how a game plays out */
+    static bool diff(const std::string& path, std::vector<bool>& changed) {
+        std::vector<Entry> saved;
+        if (!load(path, saved))
+            return false;
+
+        changed.assign(CardCollection::cardCount(), false);
+        int statChanges = 0, added = 0, renamed = 0;
+        for (ID id = 0; id < CardCollection::cardCount(); id++) {
+            if (id >= ID(saved.size())) {
+                changed[id] = true;
+                added++;
+                continue;
+            }
+            const Entry current = entryOf(id);
+            if (std::memcmp(current.edges, saved[id].edges, sizeof(current.edges)) != 0 || current.type != saved[id].type) {
+                changed[id] = true;
+                statChanges++;
+            }
+            if (current.nameHash != saved[id].nameHash)
+                renamed++;
+        }
+
+        std::cout << "Card table: " << statChanges << " cards changed stats, " << added << " added";
+        if (CardCollection::cardCount() < int(saved.size()))
+            std::cout << ", " << saved.size() - CardCollection::cardCount() << " removed";
+        if (renamed > 0)
+            std::cout << ", " << renamed << " IDs now hold a different card";
+        std::cout << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "CardCollection.hpp"
+#include "DeckStats.hpp"
+#include <array>
+#include <cmath>
+
+/* Predicts how many nodes a matchup's solve will visit, so tournaments can hand out the
+expensive ones first. The model is linear in log(nodes) over a few deck features and
+starts from a fitted prior; observe() refines it from the node counts actually measured */
+namespace CostModel {
+    static constexpr int FEATURES = 6;
+    using Features = std::array<double, FEATURES>;
+
+    struct DeckProfile {
+        double meanRank = 0.0;  // Mean edge rank, A counting as 10
+        double spread = 0.0;    // Standard deviation of the edge ranks
+        int aces = 0;           // Edges at STRENGTH_MAX
+    };
+
+    static DeckProfile profile(ID deck) {
+        DeckProfile result;
+        double sumSquares = 0.0;
+        int edges = 0;
+        for (const ID id : DeckStats::deck(deck))
+            for (int edge = 0; edge < 4; edge++) {
+                const int value = CardCollection::card(id).attribute(edge);
+                const int rank = attributeRank(value);
+                result.meanRank += rank;
+                sumSquares += rank * rank;
+                result.aces += value == STRENGTH_MAX;
+                edges++;
+            }
+        result.meanRank /= edges;
+        result.spread = std::sqrt(std::max(0.0, sumSquares / edges - result.meanRank * result.meanRank));
+        return result;
+    }
+
+    // Bias, strength difference (signed and absolute), overall strength, aces and edge spread
+    static Features features(ID redDeck, ID blueDeck) {
+        const DeckProfile red = profile(redDeck);
+        const DeckProfile blue = profile(blueDeck);
+        return {
+            1.0,
+            red.meanRank - blue.meanRank,
+            std::abs(red.meanRank - blue.meanRank),
+            (red.meanRank + blue.meanRank) / 2.0,
+            double(red.aces + blue.aces),
+            (red.spread + blue.spread) / 2.0
+        };
+    }
+
+    /* Weights of log(nodes), fitted to 200 basic-rule max-star matchups solved after two
+    scripted opening moves. Deck features alone rank costs only weakly (rank correlation
+    about 0.2), so the prior mostly sets the scale and observe() does the real work */
+    static constexpr Features PRIOR = { 12.74, -0.48, 1.13, 0.10, 0.07, -0.32 };
+    static constexpr double PRIOR_STRENGTH = 4.0; // In samples: how quickly measurements override the prior
+    static constexpr int REFIT_INTERVAL = 16;
+
+    class Predictor {
+    private:
+        Features weights = PRIOR;
+        std::array<Features, FEATURES> xtx{};  // Normal equations of the observed samples
+        Features xty{};
+        int samples = 0;
+
+        // Ridge regression pulled towards the prior: (XtX + kI) w = Xty + k * prior
+        void refit() {
+            std::array<std::array<double, FEATURES + 1>, FEATURES> system;
+            for (int i = 0; i < FEATURES; i++) {
+                for (int j = 0; j < FEATURES; j++)
+                    system[i][j] = xtx[i][j] + (i == j ? PRIOR_STRENGTH : 0.0);
+                system[i][FEATURES] = xty[i] + PRIOR_STRENGTH * PRIOR[i];
+            }
+
+            // Gaussian elimination with partial pivoting; the ridge term keeps it non-singular
+            for (int col = 0; col < FEATURES; col++) {
+                int pivot = col;
+                for (int row = col + 1; row < FEATURES; row++)
+                    if (std::abs(system[row][col]) > std::abs(system[pivot][col]))
+                        pivot = row;
+                std::swap(system[col], system[pivot]);
+                for (int row = col + 1; row < FEATURES; row++) {
+                    const double factor = system[row][col] / system[col][col];
+                    for (int k = col; k <= FEATURES; k++)
+                        system[row][k] -= factor * system[col][k];
+                }
+            }
+            for (int row = FEATURES - 1; row >= 0; row--) {
+                double value = system[row][FEATURES];
+                for (int k = row + 1; k < FEATURES; k++)
+                    value -= system[row][k] * weights[k];
+                weights[row] = value / system[row][row];
+            }
+        }
+
+    public:
+        double predictLogNodes(const Features& x) const {
+            double result = 0.0;
+            for (int i = 0; i < FEATURES; i++)
+                result += weights[i] * x[i];
+            return result;
+        }
+
+        double predictNodes(const Features& x) const {
+            return std::exp(predictLogNodes(x));
+        }
+
+        void observe(const Features& x, uint64_t nodes) {
+            const double y = std::log(double(nodes) + 1.0);
+            for (int i = 0; i < FEATURES; i++) {
+                for (int j = 0; j < FEATURES; j++)
+                    xtx[i][j] += x[i] * x[j];
+                xty[i] += x[i] * y;
+            }
+            if (++samples % REFIT_INTERVAL == 0)
+                refit();
+        }
+
+        int observed() const {
+            return samples;
+        }
+    };
+}
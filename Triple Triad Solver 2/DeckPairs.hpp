@@ -0,0 +1,36 @@
+#pragma once
+#include "defs.hpp"
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+/* Canonical numbering of unordered deck pairs {i, j}, i < j, in the order a nested
+i/j loop visits them: (0,1), (0,2) ... (0,n-1), (1,2) ... Tournaments hand out and
+merge work by these indexes, so results land in the same order however they were solved */
+namespace DeckPairs {
+    static uint64_t pairCount(uint64_t deckCount) {
+        return deckCount * (deckCount - 1) / 2;
+    }
+
+    // Pairs before row i: rows 0..i-1 hold (n-1) + (n-2) + ... + (n-i) pairs
+    static uint64_t rowStart(uint64_t row, uint64_t deckCount) {
+        return row * (2 * deckCount - row - 1) / 2;
+    }
+
+    static uint64_t indexOf(ID first, ID second, uint64_t deckCount) {
+        if (first > second)
+            std::swap(first, second);
+        return rowStart(first, deckCount) + (second - first - 1);
+    }
+
+    static std::pair<ID, ID> fromIndex(uint64_t index, uint64_t deckCount) {
+        // Estimate the row from the inverse of rowStart, then correct for rounding
+        const double n = double(deckCount);
+        uint64_t row = uint64_t((2 * n - 1 - std::sqrt((2 * n - 1) * (2 * n - 1) - 8.0 * index)) / 2);
+        while (row > 0 && rowStart(row, deckCount) > index)
+            row--;
+        while (rowStart(row + 1, deckCount) <= index)
+            row++;
+        return { ID(row), ID(row + 1 + (index - rowStart(row, deckCount))) };
+    }
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "CardCollection.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* Numbers every legal deck from 0 to count() - 1, so exhaustive studies can stream decks
+by rank instead of holding them, and split the ranks between workers. A legal deck has at
+most one 5-star card and at most two cards of 4 stars or more. Ranks are grouped by that
+split, then ordered by the combination of 5-star, 4-star and 1-3-star cards, each ranked
+in colexicographic order within its rarity bucket (the combinatorial number system) */
+class DeckRanking {
+public:
+    using Cards = std::array<ID, DECK_SIZE>; // Ascending card IDs
+    static constexpr uint64_t NOT_LEGAL = UINT64_MAX;
+
+private:
+    enum Bucket { FIVE_STAR, FOUR_STAR, LOW_STAR, BUCKETS };
+
+    struct Split {
+        int counts[BUCKETS];        // Cards drawn from each bucket
+        uint64_t sizes[BUCKETS];    // Combinations within each bucket
+        uint64_t first;             // Rank of the split's first deck
+        uint64_t size;
+    };
+
+    std::vector<ID> buckets[BUCKETS];
+    std::vector<int> bucketOf;      // Per card ID; -1 for the empty card
+    std::vector<int> positionOf;    // Per card ID, within its bucket
+    std::vector<Split> splits;
+    uint64_t total = 0;
+
+    // Colex rank of ascending indices: the sum of C(index_i, i + 1)
+    static uint64_t rankCombination(const int* indices, int k) {
+        uint64_t rank = 0;
+        for (int i = 0; i < k; i++)
+            rank += choose(indices[i], i + 1);
+        return rank;
+    }
+
+    // Greedy inverse of rankCombination(), largest index first
+    static void unrankCombination(uint64_t rank, int k, int n, int* indices) {
+        for (int i = k - 1; i >= 0; i--) {
+            int low = i, high = n - 1;  // Largest c in [low, high] with C(c, i + 1) <= rank
+            while (low < high) {
+                const int middle = (low + high + 1) / 2;
+                if (choose(middle, i + 1) <= rank)
+                    low = middle;
+                else
+                    high = middle - 1;
+            }
+            indices[i] = low;
+            rank -= choose(low, i + 1);
+            n = low;
+        }
+    }
+
+    // Steps to the next combination in colex order. On wrapping past the last, resets to the first and returns false
+    static bool nextCombination(int* indices, int k, int n) {
+        for (int i = 0; i < k; i++) {
+            const int limit = i + 1 < k ? indices[i + 1] : n;
+            if (indices[i] + 1 < limit) {
+                indices[i]++;
+                for (int j = 0; j < i; j++)
+                    indices[j] = j;
+                return true;
+            }
+        }
+        for (int j = 0; j < k; j++)
+            indices[j] = j;
+        return false;
+    }
+
+    // Deck state while streaming: the split and each bucket's chosen indices
+    struct Cursor {
+        size_t split;
+        int indices[BUCKETS][DECK_SIZE];
+    };
+
+    Cursor cursorAt(uint64_t rank) const {
+        Cursor cursor{};
+        cursor.split = 0;
+        while (rank >= splits[cursor.split].first + splits[cursor.split].size)
+            cursor.split++;
+        const Split& split = splits[cursor.split];
+        uint64_t local = rank - split.first;
+        for (int bucket = BUCKETS - 1; bucket >= 0; bucket--) { // LOW_STAR varies fastest
+            unrankCombination(local % split.sizes[bucket], split.counts[bucket], int(buckets[bucket].size()), cursor.indices[bucket]);
+            local /= split.sizes[bucket];
+        }
+        return cursor;
+    }
+
+    Cards cardsAt(const Cursor& cursor) const {
+        Cards cards;
+        int card = 0;
+        for (int bucket = 0; bucket < BUCKETS; bucket++)
+            for (int i = 0; i < splits[cursor.split].counts[bucket]; i++)
+                cards[card++] = buckets[bucket][cursor.indices[bucket][i]];
+        std::sort(cards.begin(), cards.end());
+        return cards;
+    }
+
+    void advance(Cursor& cursor) const {
+        for (int bucket = BUCKETS - 1; bucket >= 0; bucket--)
+            if (nextCombination(cursor.indices[bucket], splits[cursor.split].counts[bucket], int(buckets[bucket].size())))
+                return;
+        do // Skipping splits with no decks, as cursorAt() does
+            cursor.split++;
+        while (cursor.split < splits.size() && splits[cursor.split].size == 0);
+        if (cursor.split < splits.size())
+            for (int bucket = 0; bucket < BUCKETS; bucket++)
+                for (int i = 0; i < DECK_SIZE; i++)
+                    cursor.indices[bucket][i] = i;
+    }
+
+public:
+    // Built from CardCollection as it is now; build a new ranking after the card table changes
+    DeckRanking() {
+        bucketOf.assign(CardCollection::cardCount(), -1);
+        positionOf.assign(CardCollection::cardCount(), -1);
+        for (int stars = 1; stars <= STARS_MAX; stars++) {
+            const Bucket bucket = stars == 5 ? FIVE_STAR : stars == 4 ? FOUR_STAR : LOW_STAR;
+            for (const ID id : CardCollection::withStars(stars)) {
+                bucketOf[id] = bucket;
+                positionOf[id] = int(buckets[bucket].size());
+                buckets[bucket].push_back(id);
+            }
+        }
+
+        for (int five = 0; five <= 1; five++)
+            for (int four = 0; five + four <= 2; four++) {
+                Split split{ { five, four, DECK_SIZE - five - four }, {}, 0, 1 };
+                for (int bucket = 0; bucket < BUCKETS; bucket++) {
+                    split.sizes[bucket] = choose(buckets[bucket].size(), split.counts[bucket]);
+                    split.size *= split.sizes[bucket];
+                }
+                split.first = total;
+                total += split.size;
+                splits.push_back(split);
+            }
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    Cards unrank(uint64_t rank) const {
+        return cardsAt(cursorAt(rank));
+    }
+
+    // Rank of a deck, in any card order, or NOT_LEGAL
+    template <typename Deck>
+    uint64_t rank(const Deck& deck) const {
+        int indices[BUCKETS][DECK_SIZE];
+        int counts[BUCKETS] = {};
+        for (const ID id : deck) {
+            if (id < 0 || id >= ID(bucketOf.size()) || bucketOf[id] < 0)
+                return NOT_LEGAL;
+            indices[bucketOf[id]][counts[bucketOf[id]]++] = positionOf[id];
+        }
+
+        for (const Split& split : splits) {
+            if (!std::equal(counts, counts + BUCKETS, split.counts))
+                continue;
+            uint64_t local = 0;
+            for (int bucket = 0; bucket < BUCKETS; bucket++) {
+                std::sort(indices[bucket], indices[bucket] + counts[bucket]);
+                if (std::adjacent_find(indices[bucket], indices[bucket] + counts[bucket]) != indices[bucket] + counts[bucket])
+                    return NOT_LEGAL; // Duplicate card
+                local = local * split.sizes[bucket] + rankCombination(indices[bucket], counts[bucket]);
+            }
+            return split.first + local;
+        }
+        return NOT_LEGAL;
+    }
+
+    // Ranks [first, last) of part out of parts, near-equal in size
+    std::pair<uint64_t, uint64_t> range(uint64_t part, uint64_t parts) const {
+        const uint64_t base = total / parts, extra = total % parts;
+        const uint64_t first = part * base + std::min(part, extra);
+        return { first, first + base + (part < extra ? 1 : 0) };
+    }
+
+    // Calls f(rank, cards) for every rank in [first, last), stepping combinations rather than unranking each
+    template <typename F>
+    void forEach(uint64_t first, uint64_t last, F&& f) const {
+        if (first >= std::min(last, total))
+            return;
+        Cursor cursor = cursorAt(first);
+        for (uint64_t rank = first; rank < last && rank < total; rank++) {
+            f(rank, cardsAt(cursor));
+            advance(cursor);
+        }
+    }
+
+    /* Streams every legal deck over threads workers, each taking chunks of CHUNK ranks.
+    f(worker, rank, cards) runs concurrently, so it must only touch per-worker state */
+    template <typename F>
+    void forEachParallel(unsigned int threads, F&& f) const {
+        constexpr uint64_t CHUNK = 1 << 16;
+        std::atomic<uint64_t> nextChunk{ 0 };
+        auto worker = [&](unsigned int id) {
+            for (uint64_t first = CHUNK * nextChunk++; first < total; first = CHUNK * nextChunk++)
+                forEach(first, first + CHUNK, [&](uint64_t rank, const Cards& cards) { f(id, rank, cards); });
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned int id = 1; id < threads; id++)
+            workers.emplace_back(worker, id);
+        worker(0);
+        for (auto& thread : workers)
+            thread.join();
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "CardCollection.hpp"
+#include "DeckStats.hpp"
+#include "Rules.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* Decks whose cards have the same edges play identically, whatever the card names: many
+1-3 star cards share their stats. A deck's signature is the sorted multiset of its cards'
+(top, right, bottom, left), so matchups between equal signatures need solving only once */
+namespace DeckSignature {
+    using Signature = std::array<uint64_t, DECK_SIZE>;
+
+    // Type only matters under Ascension / Descension
+    static uint64_t cardKey(ID card, bool withType) {
+        const Card& stats = CardCollection::card(card);
+        uint64_t key = 0;
+        for (int edge = 0; edge < 4; edge++)
+            key = (key << 8) | uint64_t(stats.attribute(edge) & 0xFF);
+        if (withType)
+            key |= uint64_t(stats.type()) << 32;
+        return key;
+    }
+
+    /* Under Order the cards come out in deck order (ascending ID), so the sequence counts, not
+    just the multiset. Combined with Swap or Sudden Death the exchanged cards are re-sorted by
+    ID among the others, which stats can't capture: no two decks are treated as equal then */
+    static bool applies(Rules::Flags rules) {
+        return !((rules & Rules::ORDER) && (rules & (Rules::SWAP | Rules::SUDDEN_DEATH)));
+    }
+
+    static Signature of(ID deck, Rules::Flags rules) {
+        const bool withType = rules & (Rules::ASCENSION | Rules::DESCENSION);
+        const CardContainer& cards = DeckStats::deck(deck);
+        Signature signature{};
+        for (int i = 0; i < DECK_SIZE && i < int(cards.size()); i++)
+            signature[i] = cardKey(cards[i], withType);
+        if (!(rules & Rules::ORDER))
+            std::sort(signature.begin(), signature.end());
+        return signature;
+    }
+
+    struct Hasher {
+        size_t operator()(const Signature& signature) const {
+            uint64_t h = 0;
+            for (const uint64_t key : signature)
+                h = mix64(h ^ key);
+            return size_t(h);
+        }
+    };
+
+    // Dense signature number per deck of the pool, equal for decks that play identically
+    static std::vector<uint32_t> assign(Rules::Flags rules) {
+        std::vector<uint32_t> ids(DeckStats::deckCount());
+        if (!applies(rules)) {
+            for (ID deck = 0; deck < DeckStats::deckCount(); deck++)
+                ids[deck] = uint32_t(deck);
+            return ids;
+        }
+
+        std::unordered_map<Signature, uint32_t, Hasher> seen;
+        for (ID deck = 0; deck < DeckStats::deckCount(); deck++)
+            ids[deck] = seen.emplace(of(deck, rules), uint32_t(seen.size())).first->second;
+        return ids;
+    }
+}
@@ -1,6 +1,18 @@
 #pragma once
 #include "defs.hpp"
 #include "ELO.hpp"
+#include "Glicko.hpp"
+#include "BradleyTerry.hpp"
+#include "CardStrength.hpp"
+#include "CardSynergy.hpp"
+#include "MatchRecord.hpp"
+#include "CardCollection.hpp"
+#include "Random.hpp"
+#include "DeckRanking.hpp"
+#include "DeckStore.hpp"
+#include "MatchupMatrix.hpp"
+#include "helpers.hpp"
+#include <initializer_list>
 #include <unordered_map>
 #include <iostream>
 #include <algorithm>
@@ -14,15 +26,27 @@ public:
         WIN, DRAW, LOSS, NONE
     };
 
+    // What deck rankings are read from
+    enum RatingSystem {
+        SEQUENTIAL_ELO,     // Updated game by game as results come in
+        BRADLEY_TERRY       // Fitted over every recorded game when a ranking is asked for
+    };
+    inline static RatingSystem ratingSystem = SEQUENTIAL_ELO;
+
+    /* Keeps every game for the fitted card reports (CardStrength, CardSynergy) as well. The
+    log costs 8 bytes a game, 32 times a matchup cell, so it is only kept when something
+    reads it: set this, or the rating system, before the games are played */
+    inline static bool keepGameLog = false;
+
     struct Stats {
     private:
         ID myDeckID;
         int myWins, myDraws, myLosses;
-
-        std::unordered_map<ID, Result> playedAgainst;
+        double myScoreSum;      // Expected scores (1 win, 0.5 draw, 0 loss) of matches decided over several variants
+        int myScoredMatches;
 
     public:
-        Stats() : myDeckID(0), myWins(0), myDraws(0), myLosses(0) {
+        Stats() : myDeckID(0), myWins(0), myDraws(0), myLosses(0), myScoreSum(0.0), myScoredMatches(0) {
             ELO::initializeRatings(myDeckID);
         }
 
@@ -39,17 +63,21 @@ public:
             return myLosses;
         }
 
-        const bool& hasPlayedAgainst(const ID& targetDeck) const {
-            return playedAgainst.find(targetDeck) != playedAgainst.end();
+        int matchesPlayed() const {
+            return myWins + myLosses + myDraws;
         }
 
-        const Result& resultAgainst(const ID& targetDeck) const {
-            auto it = playedAgainst.find(targetDeck);
-            return (it != playedAgainst.end()) ? it->second : Result::NONE;
+        int scoredMatches() const {
+            return myScoredMatches;
         }
 
-        const int& matchesPlayed() const {
-            return myWins + myLosses + myDraws;
+        double scoreSum() const {
+            return myScoreSum;
+        }
+
+        // Mean expected score over scored matches, -1 if there are none
+        double expectedScore() const {
+            return myScoredMatches > 0 ? myScoreSum / myScoredMatches : -1.0;
         }
 
         const float winrate() const {
@@ -71,47 +99,182 @@ public:
             myDraws++;
         }
 
-        void addMatchupResult(ID enemyDeck, Result result) {
-            playedAgainst[enemyDeck] = result;
+        void addExpectedScore(double score) {
+            myScoreSum += score;
+            myScoredMatches++;
+        }
+
+        // Totals read back from a snapshot
+        void restoreTotals(int wins, int draws, int losses, double scoreSum, int scoredMatches) {
+            myWins = wins;
+            myDraws = draws;
+            myLosses = losses;
+            myScoreSum = scoreSum;
+            myScoredMatches = scoredMatches;
         }
     };
 
 private:
-    inline static std::vector<CardContainer> decks;
+    inline static DeckStore decks;
     inline static std::vector<Stats> stats;
+    inline static MatchupMatrix matchups;  // Latest result of every pair
+    inline static std::vector<GameResult> games; // Every recorded game, for batch fits; see logsGames()
+
+    // Sums over the decks holding a card, kept up to date as results come in
+    struct CardTotals {
+        double eloSum = 0.0;
+        int64_t wins = 0, draws = 0, losses = 0;
+    };
+    inline static std::vector<std::vector<ID>> cardDecks;  // Card ID to the decks holding it, ascending
+    inline static std::vector<CardTotals> cardTotals;      // Per card ID
+
+    static void setMatchupResult(ID deck, ID opponent, Result result) {
+        matchups.set(deck, opponent, result == NONE ? MatchupMatrix::UNPLAYED : MatchupMatrix::Cell(result + 1));
+    }
+
+    // Adds a change in one deck's ELO and record to the totals of its five cards
+    static void addToCardTotals(ID deck, double eloChange, int wins, int draws, int losses) {
+        for (int slot = 0; slot < DECK_SIZE; slot++) {
+            CardTotals& totals = cardTotals[decks.card(deck, slot)];
+            totals.eloSum += eloChange;
+            totals.wins += wins;
+            totals.draws += draws;
+            totals.losses += losses;
+        }
+    }
+
+    // Recomputes every card's totals from the decks' current ratings and records
+    static void rebuildCardTotals() {
+        cardTotals.assign(cardDecks.size(), CardTotals());
+        for (ID id = 0; id < ID(decks.size()); id++)
+            addToCardTotals(id, ELO::getElo(id), stats[id].wins(), stats[id].draws(), stats[id].losses());
+    }
 
 public:
     static bool hasPlayedAgainst(const ID& deckFirst, const ID& deckSecond) {
-        return stats[deckFirst].hasPlayedAgainst(deckSecond);
+        return matchups.hasPlayed(deckFirst, deckSecond);
+    }
+
+    static Result resultAgainst(const ID& deck, const ID& opponent) {
+        const MatchupMatrix::Cell cell = matchups.get(deck, opponent);
+        return cell == MatchupMatrix::UNPLAYED ? NONE : Result(cell - 1);
+    }
+
+    // Moves the matchup matrix into a memory-mapped scratch file, for pools too big to hold it in RAM
+    static bool mapMatchups(const std::string& path) {
+        return matchups.map(path);
+    }
+
+    static const MatchupMatrix& matchupMatrix() {
+        return matchups;
+    }
+
+    static bool logsGames() {
+        return keepGameLog || ratingSystem == BRADLEY_TERRY;
+    }
+
+    static const std::vector<GameResult>& recordedGames() {
+        return games;
+    }
+
+    static const Stats& statsOf(const ID id) {
+        return stats[id];
+    }
+
+    static void restoreTotals(ID id, int wins, int draws, int losses, double scoreSum, int scoredMatches) {
+        addToCardTotals(id, 0.0, wins - stats[id].wins(), draws - stats[id].draws(), losses - stats[id].losses());
+        stats[id].restoreTotals(wins, draws, losses, scoreSum, scoredMatches);
+    }
+
+    static void restoreElo(ID id, double elo) {
+        addToCardTotals(id, elo - ELO::getElo(id), 0, 0, 0);
+        ELO::ratings[id] = elo;
+    }
+
+    // Marks a pair as played without touching totals or ratings, which a snapshot already holds
+    static void restoreMatchup(ID redDeck, ID blueDeck, Player winner) {
+        setMatchupResult(redDeck, blueDeck, winner == PLAYER_RED ? WIN : winner == PLAYER_BLUE ? LOSS : DRAW);
+        if (logsGames())
+            games.emplace_back(redDeck, blueDeck, winner);
     }
 
     static void recordMatchResultAndUpdateELO(ID redDeck, ID blueDeck, Player winner) {
-        Result redResult, blueResult;
+        Result redResult;
 
         switch (winner) {
         case PLAYER_RED:
             redResult = Result::WIN;
-            blueResult = Result::LOSS;
             stats[redDeck].addWin();
             stats[blueDeck].addLoss();
             break;
         case PLAYER_BLUE:
             redResult = Result::LOSS;
-            blueResult = Result::WIN;
             stats[redDeck].addLoss();
             stats[blueDeck].addWin();
             break;
         case PLAYER_NONE:
             redResult = Result::DRAW;
-            blueResult = Result::DRAW;
             stats[redDeck].addDraw();
             stats[blueDeck].addDraw();
             break;
         }
 
-        stats[redDeck].addMatchupResult(blueDeck, redResult);
-        stats[blueDeck].addMatchupResult(redDeck, blueResult);
+        setMatchupResult(redDeck, blueDeck, redResult);
+        if (logsGames())
+            games.emplace_back(redDeck, blueDeck, winner);
+        const double redBefore = ELO::ratings[redDeck], blueBefore = ELO::ratings[blueDeck];
         ELO::updateElo(redDeck, blueDeck, winner);
+        addToCardTotals(redDeck, ELO::ratings[redDeck] - redBefore, redResult == WIN, redResult == DRAW, redResult == LOSS);
+        addToCardTotals(blueDeck, ELO::ratings[blueDeck] - blueBefore, redResult == LOSS, redResult == DRAW, redResult == WIN);
+        Glicko::update(redDeck, blueDeck, winner == PLAYER_RED ? 1.0 : winner == PLAYER_BLUE ? 0.0 : 0.5);
+    }
+
+    /* Swap rule matches are worth an expected score for RED over every possible exchange.
+    The W/L/D record and ELO take the result that score favours */
+    static void recordSwapResultAndUpdateELO(ID redDeck, ID blueDeck, double redExpectedScore) {
+        stats[redDeck].addExpectedScore(redExpectedScore);
+        stats[blueDeck].addExpectedScore(1.0 - redExpectedScore);
+
+        const Player favoured = redExpectedScore > 0.5 ? PLAYER_RED
+            : redExpectedScore < 0.5 ? PLAYER_BLUE : PLAYER_NONE;
+        recordMatchResultAndUpdateELO(redDeck, blueDeck, favoured);
+    }
+
+    static void recordMatch(const MatchRecord& match) {
+        if (match.redScore >= 0.0)
+            recordSwapResultAndUpdateELO(match.redDeck, match.blueDeck, match.redScore);
+        else
+            recordMatchResultAndUpdateELO(match.redDeck, match.blueDeck, match.result);
+    }
+
+    // Forgets every deck, result and rating
+    static void clear() {
+        decks.clear();
+        stats.clear();
+        matchups.resize(0);
+        games.clear();
+        cardDecks.clear();
+        cardTotals.clear();
+        CardStrength::clear();
+        BradleyTerry::ratings.clear();
+        ELO::ratings.clear();
+        Glicko::ratings.clear();
+    }
+
+    // Forgets every result and rating, keeping the decks
+    static void resetResults() {
+        stats.assign(decks.size(), Stats());
+        matchups.clear();
+        games.clear();
+        CardStrength::clear();
+        BradleyTerry::ratings.clear();
+        ELO::ratings.clear();
+        Glicko::ratings.clear();
+        for (ID id = 0; id < ID(decks.size()); id++) {
+            ELO::initializeRatings(id);
+            Glicko::initializeRatings(id);
+        }
+        rebuildCardTotals();
     }
 
     static int deckCount() {
@@ -129,15 +292,34 @@ public:
         return bestID;
     }
 
-    static const CardContainer& deck(const ID id) {
-        return decks[id];
+    // Fingerprint of the deck pool, so separately generated pools can be checked to agree on IDs
+    static uint64_t poolHash() {
+        return poolHash(decks.size());
     }
 
-    static ID id(const CardContainer deck) {
-        for (int i = 0; i < stats.size(); i++)
-            if (decks[i] == deck)
-                return i;
-        std::cout << "DeckStats::getID() failed to find any deck which matched" << std::endl;
+    // Fingerprint of the first count decks, which a pool grown by addIfUnique keeps
+    static uint64_t poolHash(size_t count) {
+        uint64_t h = mix64(count);
+        for (size_t deck = 0; deck < count; deck++)
+            for (int card = 0; card < DECK_SIZE; card++)
+                h = mix64(h ^ uint64_t(decks.card(ID(deck), card)));
+        return h;
+    }
+
+    // The deck's card IDs, ascending, unpacked from the store
+    static CardContainer deck(const ID id) {
+        return decks.cards(id);
+    }
+
+    static ID card(const ID id, int slot) {
+        return decks.card(id, slot);
+    }
+
+    static ID id(const CardContainer& deck) {
+        const ID found = decks.find(DeckStore::pack(deck));
+        if (found < 0)
+            std::cout << "DeckStats::getID() failed to find any deck which matched" << std::endl;
+        return found;
     }
 
     static void sort(CardContainer& deck) {
@@ -171,204 +353,280 @@ public:
             && fiveStarCount < 2 && deck.size() == DECK_SIZE;
     }
 
-    static int randomID() {
-        return std::rand() % stats.size();
+    static int randomID(Random::Generator& rng) {
+        return int(rng.below(stats.size()));
+    }
+
+    /* Appends count distinct cards, drawn uniformly from the listed star buckets taken as one
+    list. Floyd's algorithm: every draw is kept, so there is nothing to retry */
+    static void drawDistinct(std::initializer_list<int> starCounts, int count, Random::Generator& rng, CardContainer& deck) {
+        uint64_t size = 0;
+        for (const int stars : starCounts)
+            size += CardCollection::withStars(stars).size();
+        if (size < uint64_t(count)) {
+            std::cout << "DeckStats::drawDistinct() has too few cards of the requested rarity" << std::endl;
+            return;
+        }
+
+        uint64_t chosen[DECK_SIZE];
+        int found = 0;
+        for (uint64_t j = size - count; j < size; j++) {
+            uint64_t pick = rng.below(j + 1);
+            if (std::find(chosen, chosen + found, pick) != chosen + found)
+                pick = j;
+            chosen[found++] = pick;
+        }
+
+        for (int i = 0; i < found; i++)
+            for (const int stars : starCounts) {
+                const std::vector<ID>& bucket = CardCollection::withStars(stars);
+                if (chosen[i] < bucket.size()) {
+                    deck.push_back(bucket[chosen[i]]);
+                    break;
+                }
+                chosen[i] -= bucket.size();
+            }
     }
 
-    static CardContainer createRandom() {
-        CardContainer tmpDeck;
-        do {
-            tmpDeck.clear();
-            for (int j = 0; j < DECK_SIZE; j++) {
-                tmpDeck.push_back(CardCollection::randomID());
+    /* Uniform over every legal deck: the number of 4- and 5-star cards is chosen first, each
+    split weighted by how many legal decks it allows, then the cards of each rarity */
+    static CardContainer createRandom(Random::Generator& rng) {
+        const uint64_t fiveStars = CardCollection::withStars(5).size();
+        const uint64_t fourStars = CardCollection::withStars(4).size();
+        uint64_t lowStars = 0;
+        for (int stars = 1; stars <= 3; stars++)
+            lowStars += CardCollection::withStars(stars).size();
+
+        // At most one 5-star card, and at most two cards of 4 stars or more
+        uint64_t weights[2][3] = {};
+        uint64_t total = 0;
+        for (int five = 0; five <= 1; five++)
+            for (int four = 0; five + four <= 2; four++) {
+                weights[five][four] = choose(fiveStars, five) * choose(fourStars, four) * choose(lowStars, DECK_SIZE - five - four);
+                total += weights[five][four];
+            }
+
+        uint64_t pick = rng.below(total);
+        int five = 0, four = 0;
+        while (pick >= weights[five][four]) {
+            pick -= weights[five][four];
+            if (five + ++four > 2) {
+                five++;
+                four = 0;
             }
-        } while (!isLegal(tmpDeck));
-        std::sort(tmpDeck.begin(), tmpDeck.end());
-        return tmpDeck;
+        }
+
+        CardContainer deck;
+        deck.reserve(DECK_SIZE);
+        drawDistinct({ 5 }, five, rng, deck);
+        drawDistinct({ 4 }, four, rng, deck);
+        drawDistinct({ 1, 2, 3 }, DECK_SIZE - five - four, rng, deck);
+        std::sort(deck.begin(), deck.end());
+        return deck;
     }
 
-    static bool matchFound(const CardContainer targetDeck) {
-        // Assumes targetDeck is sorted
-        for (int i = 0; i < stats.size(); i++)
-            if (targetDeck == decks[i])
-                return true;
-        return false;
+    static bool matchFound(const CardContainer& targetDeck) {
+        return decks.find(DeckStore::pack(targetDeck)) >= 0;
     }
 
-    static void addIfUnique(CardContainer deck) {
-        sort(deck);
-        if (!matchFound(deck)) {
-            decks.push_back(deck);
+    static void addIfUnique(const CardContainer& deck) {
+        if (decks.add(DeckStore::pack(deck))) {
+            const ID id = ID(decks.size() - 1);
             stats.push_back(Stats());
-            ELO::initializeRatings(decks.size() - 1);
+            matchups.resize(int(decks.size()));
+            ELO::initializeRatings(id);
+            Glicko::initializeRatings(id);
+            for (int slot = 0; slot < DECK_SIZE; slot++) {
+                const ID card = decks.card(id, slot);
+                if (card >= ID(cardDecks.size())) {
+                    cardDecks.resize(std::max<size_t>(card + 1, CardCollection::cardCount()));
+                    cardTotals.resize(cardDecks.size());
+                }
+                cardDecks[card].push_back(id);
+            }
+            addToCardTotals(id, ELO::getElo(id), 0, 0, 0);
         }
     }
 
-    static void initRandoms(const int count) {
+    static void initRandoms(const int count, Random::Generator& rng) {
         while (stats.size() < count)
-            addIfUnique(createRandom());
+            addIfUnique(createRandom(rng));
     }
 
-    static CardContainer randomFromStarCriteria(const int askingCount[STARS_MAX]) {
-        int found[STARS_MAX] = { 0, 0, 0, 0 ,0 };
+    static CardContainer randomFromStarCriteria(const int askingCount[STARS_MAX], Random::Generator& rng) {
         CardContainer cards;
         cards.reserve(DECK_SIZE);
-
-        for (int i = 0; i < STARS_MAX; i++) {
-            while (found[i] < askingCount[i]) {
-                const ID& id = CardCollection::randomWithStarsID(i + 1);
-                bool duplicateFound = false;
-                for (int j = 0; j < cards.size(); j++)
-                    if (cards[j] == id)
-                        duplicateFound = true;
-                if (!duplicateFound) {
-                    found[i]++;
-                    cards.push_back(id);
-                }
-            }
-        }
+        for (int i = 0; i < STARS_MAX; i++)
+            drawDistinct({ i + 1 }, askingCount[i], rng, cards);
         return cards;
     }
 
-    static CardContainer createWithMaxStars() {
+    static CardContainer createWithMaxStars(Random::Generator& rng) {
         // 0x 1-star, 0x 2-star, 3x 3-star, 1x 4-star, 1x 5-star
         const int maxStars[5] = { 0, 0, 3, 1, 1 };
-        return randomFromStarCriteria(maxStars);
+        return randomFromStarCriteria(maxStars, rng);
     }
 
-    static void initWithMaxStars(const int count) {
+    static void initWithMaxStars(const int count, Random::Generator& rng) {
         while (stats.size() < count)
-            addIfUnique(createWithMaxStars());
+            addIfUnique(createWithMaxStars(rng));
     }
 
-    static void initAllPossible() {
-        CardContainer deck(DECK_SIZE);
-        std::vector<uint16_t> cards;
-        std::iota(cards.begin(), cards.end(), 1);  // Fill with {1, 2, 3, ..., TRIPLE_TRIAD_CARD_COUNT}
-
-        // Generate all unique 5-card combinations
-        std::vector<bool> selector(cards.size(), false);
-        std::fill(selector.begin(), selector.begin() + DECK_SIZE, true);  // First DECK_SIZE elements = true
-
-        do {
-            int index = 0;
-            for (int i = 0; i < cards.size(); i++)
-                if (selector[i]) deck[index++] = cards[i];
-
-            addIfUnique(deck);
-        } while (std::prev_permutation(selector.begin(), selector.end()));
+    /* Adds every legal deck. DeckRanking counts them first: the full card table has billions,
+    which exhaustive studies should stream through DeckRanking::forEach() instead of storing */
+    static void initAllPossible(uint64_t maxDecks = uint64_t(1) << 24) {
+        const DeckRanking ranking;
+        if (ranking.count() > maxDecks) {
+            std::cout << "DeckStats::initAllPossible() " << ranking.count() << " legal decks exceed the limit of "
+                << maxDecks << "; stream them with DeckRanking instead" << std::endl;
+            return;
+        }
+        ranking.forEach(0, ranking.count(), [](uint64_t, const DeckRanking::Cards& cards) {
+            addIfUnique(CardContainer(cards.begin(), cards.end()));
+        });
     }
 
     static bool containsCard(ID deckID, ID cardID) {
-        for (int i = 0; i < DECK_SIZE; i++)
-            if (deck(deckID).at(i) == cardID)
-                return true;
-        return false;
+        return decks.contains(deckID, cardID);
     }
 
-    static double averageELOofCard(ID card) {
-        double sumELO = 0;
-        int matchHits = 0;
-        for (int i = 0; i < decks.size(); i++) {
-            if (containsCard(i, card)) {
-                double deckElo = ELO::getElo(i);
-                if (deckElo != -1.0) {  // Ensure Elo is valid
-                    sumELO += deckElo;
-                    matchHits++;
-                }
-            }
-        }
-
-        // Avoid division by zero if no valid decks contain the card
-        return matchHits > 0 ? sumELO / matchHits : 0.0;
+    // The decks holding the card, ascending
+    static const std::vector<ID>& decksWithCard(ID card) {
+        static const std::vector<ID> none;
+        return card >= 0 && card < ID(cardDecks.size()) ? cardDecks[card] : none;
     }
 
-    static std::vector<std::pair<ID, double>> topPerformingCards(int topX) {
-        std::vector<std::pair<ID, double>> cardELOs;
-
-        for (int i = 0; i < CardCollection::cardCount(); i++)
-            cardELOs.push_back({ i, averageELOofCard(i)});
+    // Mean ELO of the decks holding the card, or 0 if there are none
+    static double averageELOofCard(ID card) {
+        const std::vector<ID>& holders = decksWithCard(card);
+        return holders.empty() ? 0.0 : cardTotals[card].eloSum / holders.size();
+    }
 
-        // Sort the cards in descending order of Elo
-        std::sort(cardELOs.begin(), cardELOs.end(),
-            [](const std::pair<ID, double>& a, const std::pair<ID, double>& b) {
-                return a.second > b.second;
-            });
+    /* Cards by the mean ELO of the decks holding them, best first when descending. The sums
+    are kept up to date game by game, so this is cheap enough to call mid-tournament; the
+    CardStrength ranking below is the more accurate one, but refits over every game */
+    static std::vector<std::pair<ID, double>> cardsByAverageELO(int count, bool descending = true) {
+        std::vector<std::pair<ID, double>> cards;
+        for (ID card = 0; card < ID(cardDecks.size()); card++)
+            if (!cardDecks[card].empty())
+                cards.push_back({ card, averageELOofCard(card) });
+        count = std::min(count, int(cards.size()));
+        std::partial_sort(cards.begin(), cards.begin() + count, cards.end(), [descending](const auto& a, const auto& b) {
+            if (a.second != b.second)
+                return descending ? a.second > b.second : a.second < b.second;
+            return a.first < b.first;
+        });
+        cards.resize(count);
+        return cards;
+    }
 
-        // Extract the top X performing cards
-        std::vector<std::pair<ID, double>> topCards;
-        for (int i = 0; i < topX && i < cardELOs.size(); i++) {
-            topCards.push_back(cardELOs[i]);
+    static void printCardStandings(int numCards) {
+        std::cout << std::endl;
+        std::cout << "----------------------- Displaying Card Standings ----------------------- " << std::endl;
+        for (const auto& card : cardsByAverageELO(numCards)) {
+            const CardTotals& totals = cardTotals[card.first];
+            std::cout << std::endl;
+            std::cout << "Average ELO: " << card.second << " over " << cardDecks[card.first].size() << " decks" << std::endl;
+            std::cout << "Card: " << CardCollection::name(card.first) << std::endl;
+            std::cout << "W: " << totals.wins << " | L: " << totals.losses << " | D: " << totals.draws << std::endl;
         }
+    }
 
-        return topCards;  // Returns a vector of pairs {cardID, averageELO}
+    /* Cards ranked by CardStrength, fitted over every recorded game, so a card isn't credited
+    for its deck-mates; the fit is reused until more games are recorded. Only cards in decks
+    that have played are ranked. Without the game log this falls back to the mean ELO of the
+    decks holding each card */
+    static std::vector<std::pair<ID, double>> topPerformingCards(int topX) {
+        if (!logsGames())
+            return cardsByAverageELO(topX, true);
+        CardStrength::fit(games, decks, CardCollection::cardCount());
+        std::vector<std::pair<ID, double>> topCards = CardStrength::ranked(true);
+        topCards.resize(std::min<size_t>(topCards.size(), topX));
+        return topCards;  // Returns a vector of pairs {cardID, strength in ELO points}
     }
 
     static std::vector<std::pair<ID, double>> lowestPerformingCards(int bottomX) {
-        std::vector<std::pair<ID, double>> cardELOs;
-
-        for (int i = 0; i < CardCollection::cardCount(); i++) {
-            double cardElo = averageELOofCard(i);
-            if (cardElo > 0) {  // Only include cards with Elo > 0
-                cardELOs.push_back({ i, cardElo });
-            }
-        }
-
-        // Sort the cards in ascending order of Elo to get the lowest-performing cards
-        std::sort(cardELOs.begin(), cardELOs.end(),
-            [](const std::pair<ID, double>& a, const std::pair<ID, double>& b) {
-                return a.second < b.second;  // Ascending order for lowest ELO
-            });
-
-        // Extract the bottom X lowest-performing cards
-        std::vector<std::pair<ID, double>> bottomCards;
-        for (int i = 0; i < bottomX && i < cardELOs.size(); i++) {
-            bottomCards.push_back(cardELOs[i]);
-        }
-
-        return bottomCards;  // Returns a vector of pairs {cardID, averageELO}
+        if (!logsGames())
+            return cardsByAverageELO(bottomX, false);
+        CardStrength::fit(games, decks, CardCollection::cardCount());
+        std::vector<std::pair<ID, double>> bottomCards = CardStrength::ranked(false);
+        bottomCards.resize(std::min<size_t>(bottomCards.size(), bottomX));
+        return bottomCards;  // Returns a vector of pairs {cardID, strength in ELO points}
     }
 
     static void printBestCards(int numCards) {
         std::cout << std::endl;
         std::cout << "----------------------- Displaying Best Performing Cards ----------------------- " << std::endl;
         std::vector<std::pair<ID, double>> topCards = topPerformingCards(numCards);
-        for (int i = 0; i < numCards; i++)
-            printCardPerformance(topCards[i]);
+        for (const auto& card : topCards)
+            printCardPerformance(card);
     }
 
     static void printWorstCards(int numCards) {
         std::cout << std::endl;
         std::cout << "----------------------- Displaying Lowest Performing Cards ----------------------- " << std::endl;
         std::vector<std::pair<ID, double>> lowestCards = lowestPerformingCards(numCards);
-        for (int i = 0; i < numCards; i++)
-            printCardPerformance(lowestCards[i]);
+        for (const auto& card : lowestCards)
+            printCardPerformance(card);
+    }
+
+    /* Card pairs that score most above, or when worst is set most below, what their cards
+    manage apart. Pairs held by fewer than minDecks decks are left out */
+    static void printCardSynergies(int numPairs, uint64_t minDecks = 10, bool worst = false) {
+        std::cout << std::endl;
+        std::cout << "----------------------- Displaying " << (worst ? "Worst" : "Best") << " Card Pairs ----------------------- " << std::endl;
+        if (!logsGames()) {
+            std::cout << "DeckStats::printCardSynergies() needs the game log: set keepGameLog before playing" << std::endl;
+            return;
+        }
+        CardSynergy::compute(games, decks, CardCollection::cardCount());
+        for (const CardSynergy::Synergy& pair : CardSynergy::ranked(numPairs, minDecks, !worst)) {
+            const CardSynergy::Tally& tally = CardSynergy::tally(pair.first, pair.second);
+            std::cout << std::endl;
+            std::cout << "Synergy: " << pair.synergy << " ELO" << std::endl;
+            std::cout << "Cards: " << CardCollection::name(pair.first) << " + " << CardCollection::name(pair.second) << std::endl;
+            std::cout << "Decks: " << tally.decks << " | W: " << tally.wins << " | L: " << tally.losses << " | D: " << tally.draws
+                << " | Score: " << tally.score() * 100 << "% vs " << CardSynergy::expectedScore(pair.first, pair.second) * 100 << "% expected" << std::endl;
+        }
     }
-    
+
+    // The best decks by ratingSystem. Bradley-Terry ratings are fitted afresh over every game recorded so far
+    static std::vector<ID> topDecks(int numDecks) {
+        if (ratingSystem == BRADLEY_TERRY) {
+            BradleyTerry::fit(games, deckCount());
+            return BradleyTerry::getTopDecks(numDecks);
+        }
+        return ELO::getTopDecks(numDecks);
+    }
+
     static void printBestPerforming(int numDecks) {
         std::cout << std::endl;
         std::cout << "----------------------- Displaying Best Performing Decks -----------------------" << std::endl;
-        std::vector<ID> topDecks = ELO::getTopDecks(numDecks);
+        std::vector<ID> topDecks = DeckStats::topDecks(numDecks);
         for (int i = 0; i < topDecks.size(); i++)
             DeckStats::print(topDecks[i]);
     }
 
     static void printCardPerformance(std::pair<ID, double> performance) {
         std::cout << std::endl;
-        std::cout << "ELO: " << performance.second << std::endl;
+        std::cout << (logsGames() ? "Strength: " : "Average ELO: ") << performance.second << (logsGames() ? " ELO" : "") << std::endl;
         std::cout << "Card: " << CardCollection::name(performance.first) << std::endl;
     }
 
     static void print(ID id) {
         std::cout << std::endl;
         std::cout << "ELO: " << ELO::getElo(id) << std::endl;
+        if (ratingSystem == BRADLEY_TERRY)
+            std::cout << "Bradley-Terry: " << BradleyTerry::rating(id) << std::endl;
         std::cout << "Winrate: " << stats[id].winrate() * 100 << "%" << std::endl;
         std::cout << "Best Win-Loss-Draw: " << std::endl;
         std::cout << "W: " << stats[id].wins() << " | L: " << stats[id].losses() << " | D: " << stats[id].draws() << std::endl;
+        if (stats[id].scoredMatches() > 0)
+            std::cout << "Expected Score: " << stats[id].expectedScore() * 100 << "% over " << stats[id].scoredMatches() << " matches" << std::endl;
         std::cout << "Deck List: " << std::endl;
 
-        for (int i = 0; i < decks[id].size(); i++)
-            std::cout << CardCollection::name(decks[id][i]) << " (" << int(CardCollection::card(decks[id][i]).stars()) << "-Star), ";
+        for (int i = 0; i < DECK_SIZE; i++)
+            std::cout << CardCollection::name(card(id, i)) << " (" << int(CardCollection::card(card(id, i)).stars()) << "-Star), ";
         std::cout << std::endl;
     }
 
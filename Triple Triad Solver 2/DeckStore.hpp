@@ -0,0 +1,120 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/* The deck pool as one flat array of packed keys: a deck's card IDs, ascending, CARD_BITS
+apiece in a single uint64_t. An open-addressing index from key to deck ID (linear probing,
+kept under 70% load) makes lookups and unique inserts O(1). A deck costs its 8-byte key
+plus 4-byte index slots, instead of a heap-allocated vector and a hash map node */
+class DeckStore {
+public:
+    static constexpr int CARD_BITS = 12; // So card IDs must stay below 4096
+    static constexpr uint64_t CARD_MASK = (uint64_t(1) << CARD_BITS) - 1;
+    static_assert(CARD_BITS * DECK_SIZE <= 64, "A packed deck must fit in one key");
+
+private:
+    static constexpr size_t MIN_CAPACITY = 1024;   // Index slots, always a power of 2
+
+    std::vector<uint64_t> keys;     // By deck ID
+    std::vector<uint32_t> slots;    // Deck ID + 1, or 0 when empty
+
+    size_t slotOf(uint64_t key) const {
+        const size_t mask = slots.size() - 1;
+        size_t slot = size_t(mix64(key)) & mask;
+        while (slots[slot] != 0 && keys[slots[slot] - 1] != key)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, 0);
+        for (size_t id = 0; id < keys.size(); id++)
+            slots[slotOf(keys[id])] = uint32_t(id + 1);
+    }
+
+public:
+    // Packs the deck's cards in ascending order, so every ordering of a deck shares a key
+    static uint64_t pack(CardContainer deck) {
+        std::sort(deck.begin(), deck.end());
+        uint64_t key = 0;
+        for (int i = 0; i < DECK_SIZE; i++)
+            key |= uint64_t(deck[i]) << (i * CARD_BITS);
+        return key;
+    }
+
+    static ID cardOf(uint64_t key, int slot) {
+        return ID((key >> (slot * CARD_BITS)) & CARD_MASK);
+    }
+
+    static CardContainer unpack(uint64_t key) {
+        CardContainer deck(DECK_SIZE);
+        for (int i = 0; i < DECK_SIZE; i++)
+            deck[i] = cardOf(key, i);
+        return deck;
+    }
+
+    size_t size() const {
+        return keys.size();
+    }
+
+    uint64_t key(ID id) const {
+        return keys[id];
+    }
+
+    // The deck's card IDs, ascending
+    CardContainer cards(ID id) const {
+        return unpack(keys[id]);
+    }
+
+    ID card(ID id, int slot) const {
+        return cardOf(keys[id], slot);
+    }
+
+    bool contains(ID id, ID card) const {
+        for (int i = 0; i < DECK_SIZE; i++)
+            if (cardOf(keys[id], i) == card)
+                return true;
+        return false;
+    }
+
+    // The deck ID holding key, or -1
+    ID find(uint64_t key) const {
+        if (slots.empty())
+            return -1;
+        const uint32_t entry = slots[slotOf(key)];
+        return entry != 0 ? ID(entry - 1) : -1;
+    }
+
+    // Appends the deck unless it is already stored. Returns whether it was added
+    bool add(uint64_t key) {
+        if ((keys.size() + 1) * 10 > slots.size() * 7)
+            rehash(std::max(MIN_CAPACITY, 2 * slots.size()));
+        const size_t slot = slotOf(key);
+        if (slots[slot] != 0)
+            return false;
+        keys.push_back(key);
+        slots[slot] = uint32_t(keys.size());
+        return true;
+    }
+
+    void reserve(size_t count) {
+        keys.reserve(count);
+        size_t capacity = std::max(MIN_CAPACITY, slots.size());
+        while (count * 10 > capacity * 7)
+            capacity *= 2;
+        if (capacity > slots.size())
+            rehash(capacity);
+    }
+
+    void clear() {
+        keys.clear();
+        slots.clear();
+    }
+
+    size_t memoryUsage() const {
+        return keys.capacity() * sizeof(uint64_t) + slots.capacity() * sizeof(uint32_t);
+    }
+};
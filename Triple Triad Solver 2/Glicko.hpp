@@ -0,0 +1,127 @@
+#pragma once
+#include "defs.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/* Glicko-2 ratings: like ELO, but every deck also carries a rating deviation saying how
+sure the rating is, so schedulers can tell which decks still need games and when a
+leaderboard has settled. Each game is rated as its own rating period */
+namespace Glicko {
+    struct Rating {
+        double mu = 0.0;        // Rating on the Glicko-2 scale: (r - 1500) / SCALE
+        double phi = 350.0 / 173.7178;  // Deviation on the same scale
+        double sigma = 0.06;    // Volatility
+    };
+
+    static std::unordered_map<ID, Rating> ratings;
+
+    static constexpr double SCALE = 173.7178;
+    static constexpr double TAU = 0.5;      // Limits how fast volatility moves
+    static constexpr double EPSILON = 0.000001;
+    static constexpr double PI = 3.14159265358979323846;
+
+    static void initializeRatings(ID deck) {
+        if (ratings.find(deck) == ratings.end())
+            ratings[deck] = Rating();
+    }
+
+    static double g(double phi) {
+        return 1.0 / std::sqrt(1.0 + 3.0 * phi * phi / (PI * PI));
+    }
+
+    // Expected score of a rating against an opponent of mu / phi
+    static double expectedScore(const Rating& player, const Rating& opponent) {
+        return 1.0 / (1.0 + std::exp(-g(opponent.phi) * (player.mu - opponent.mu)));
+    }
+
+    // New volatility by the Illinois iteration of the Glicko-2 paper
+    static double updatedVolatility(const Rating& player, double delta, double v) {
+        const double a = std::log(player.sigma * player.sigma);
+        const auto f = [&](double x) {
+            const double ex = std::exp(x);
+            const double denominator = player.phi * player.phi + v + ex;
+            return ex * (delta * delta - denominator) / (2.0 * denominator * denominator) - (x - a) / (TAU * TAU);
+        };
+
+        double A = a, B;
+        if (delta * delta > player.phi * player.phi + v)
+            B = std::log(delta * delta - player.phi * player.phi - v);
+        else {
+            int k = 1;
+            while (f(a - k * TAU) < 0.0)
+                k++;
+            B = a - k * TAU;
+        }
+
+        double fA = f(A), fB = f(B);
+        while (std::abs(B - A) > EPSILON) {
+            const double C = A + (A - B) * fA / (fB - fA);
+            const double fC = f(C);
+            if (fC * fB <= 0.0) {
+                A = B;
+                fA = fB;
+            }
+            else
+                fA /= 2.0;
+            B = C;
+            fB = fC;
+        }
+        return std::exp(A / 2.0);
+    }
+
+    static Rating updated(const Rating& player, const Rating& opponent, double score) {
+        const double expected = expectedScore(player, opponent);
+        const double gOpponent = g(opponent.phi);
+        const double v = 1.0 / (gOpponent * gOpponent * expected * (1.0 - expected));
+        const double delta = v * gOpponent * (score - expected);
+
+        Rating result;
+        result.sigma = updatedVolatility(player, delta, v);
+        const double phiStar = std::sqrt(player.phi * player.phi + result.sigma * result.sigma);
+        result.phi = 1.0 / std::sqrt(1.0 / (phiStar * phiStar) + 1.0 / v);
+        result.mu = player.mu + result.phi * result.phi * gOpponent * (score - expected);
+        return result;
+    }
+
+    // redScore: 1 win, 0.5 draw, 0 loss
+    static void update(ID redDeck, ID blueDeck, double redScore) {
+        const Rating red = ratings[redDeck];
+        const Rating blue = ratings[blueDeck];
+        ratings[redDeck] = updated(red, blue, redScore);
+        ratings[blueDeck] = updated(blue, red, 1.0 - redScore);
+    }
+
+    // On the familiar 1500-centred scale
+    static double rating(ID deck) {
+        return 1500.0 + SCALE * ratings[deck].mu;
+    }
+
+    static double deviation(ID deck) {
+        return SCALE * ratings[deck].phi;
+    }
+
+    // Deviation left after one more game against opponent, without playing it
+    static double deviationAfterGame(ID deck, ID opponent) {
+        const Rating& player = ratings[deck];
+        const double expected = expectedScore(player, ratings[opponent]);
+        const double gOpponent = g(ratings[opponent].phi);
+        const double information = gOpponent * gOpponent * expected * (1.0 - expected);
+        return SCALE / std::sqrt(1.0 / (player.phi * player.phi) + information);
+    }
+
+    static std::vector<ID> getTopDecks(int numTopDecks) {
+        std::vector<std::pair<ID, double>> sortedDecks;
+        for (const auto& [deck, rating] : ratings)
+            sortedDecks.push_back({ deck, rating.mu });
+
+        std::sort(sortedDecks.begin(), sortedDecks.end(),
+            [](const auto& a, const auto& b) { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+
+        std::vector<ID> topDecks;
+        for (int i = 0; i < numTopDecks && i < sortedDecks.size(); i++)
+            topDecks.push_back(sortedDecks[i].first);
+        return topDecks;
+    }
+}
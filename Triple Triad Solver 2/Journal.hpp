@@ -0,0 +1,339 @@
+#pragma once
+#include "defs.hpp"
+#include "MatchRecord.hpp"
+#include "ShardFile.hpp"
+#include "DeckStats.hpp"
+#include "ELO.hpp"
+#include "Glicko.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* Crash-safe record of a long run. Every match result is appended to a journal, buffered
+and fsynced in batches, so a crash loses at most the last unsynced batch, and those
+matches are simply solved again. Periodic snapshots (<path>.snapshot) hold the per-deck
+totals and ELO / Glicko ratings, so resuming restores them and replays only the journal
+tail through the rating updates. Earlier records just mark their pairs as played.
+Snapshots are written to a temporary file and renamed over the old one, so a crash
+mid-write leaves the previous snapshot intact */
+namespace Journal {
+    static constexpr char MAGIC[4] = { 'T', 'T', 'J', 'N' };
+    static constexpr char SNAPSHOT_MAGIC[4] = { 'T', 'T', 'S', 'S' };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t BATCH_RECORDS = 1024;   // Records buffered before a sync
+    static constexpr double BATCH_SECONDS = 10.0;   // Longest a record waits for a sync
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t poolHash;      // DeckStats::poolHash() of the pool the run is played on
+        uint64_t seed;          // PairSampler seed of random play, so a resumed run walks the same permutation
+        uint32_t deckCount;
+        uint32_t rules;         // Rules::Flags
+
+        bool sameRun(const Header& other) const {
+            return poolHash == other.poolHash && deckCount == other.deckCount && rules == other.rules;
+        }
+    };
+
+    struct SnapshotHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t poolHash;
+        uint64_t journalRecords;    // Journal records the snapshot includes
+        uint64_t samplerPosition;   // Where random play had got to
+        uint32_t deckCount;
+        uint32_t reserved;
+    };
+
+    struct DeckRecord {
+        int32_t wins, draws, losses, scoredMatches;
+        double scoreSum;
+        double elo;
+        double mu, phi, sigma;
+    };
+    static_assert(sizeof(Header) == 32 && sizeof(SnapshotHeader) == 40 && sizeof(DeckRecord) == 56,
+        "Journal layout must not depend on padding");
+
+    static Header makeHeader(uint64_t seed, uint32_t rules) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.poolHash = DeckStats::poolHash();
+        header.seed = seed;
+        header.deckCount = uint32_t(DeckStats::deckCount());
+        header.rules = rules;
+        return header;
+    }
+
+    // Flushes the C library buffer and has the OS write the file to disk
+    static void syncToDisk(FILE* file) {
+        std::fflush(file);
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    static FILE* openFile(const std::string& path, const char* mode) {
+#ifdef _WIN32
+        FILE* file = nullptr;
+        return fopen_s(&file, path.c_str(), mode) == 0 ? file : nullptr;
+#else
+        return std::fopen(path.c_str(), mode);
+#endif
+    }
+
+    /* Replaces the file at path with what write() puts in it, through a synced temporary file
+    and a rename, so a crash or a full disk mid-write leaves the old file whole. write()
+    returns whether all of its writes went through */
+    template <typename F>
+    static bool replaceFile(const std::string& path, F&& write) {
+        const std::string temporary = path + ".tmp";
+        FILE* file = openFile(temporary, "wb");
+        if (!file) {
+            std::cout << "Journal::replaceFile() could not open " << temporary << std::endl;
+            return false;
+        }
+        bool written = write(file);
+        syncToDisk(file);
+        written = std::fclose(file) == 0 && written;
+        std::error_code error;
+        if (written)
+            std::filesystem::rename(temporary, path, error);
+        if (!written || error) {
+            std::cout << "Journal::replaceFile() could not write " << path << std::endl;
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    static std::string snapshotPath(const std::string& path) {
+        return path + ".snapshot";
+    }
+
+    // Writes the current DeckStats and ratings as covering the first journalRecords records
+    static bool writeSnapshot(const std::string& path, uint64_t journalRecords, uint64_t samplerPosition) {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = VERSION;
+        header.poolHash = DeckStats::poolHash();
+        header.journalRecords = journalRecords;
+        header.samplerPosition = samplerPosition;
+        header.deckCount = uint32_t(DeckStats::deckCount());
+
+        std::vector<DeckRecord> decks(header.deckCount);
+        for (ID id = 0; id < ID(header.deckCount); id++) {
+            const DeckStats::Stats& stats = DeckStats::statsOf(id);
+            const Glicko::Rating& rating = Glicko::ratings[id];
+            decks[id] = { stats.wins(), stats.draws(), stats.losses(), stats.scoredMatches(),
+                stats.scoreSum(), ELO::ratings[id], rating.mu, rating.phi, rating.sigma };
+        }
+
+        const std::string temporary = snapshotPath(path) + ".tmp";
+        FILE* file = openFile(temporary, "wb");
+        if (!file) {
+            std::cout << "Journal::writeSnapshot() could not open " << temporary << std::endl;
+            return false;
+        }
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fwrite(decks.data(), sizeof(DeckRecord), decks.size(), file);
+        syncToDisk(file);
+        std::fclose(file);
+        std::filesystem::rename(temporary, snapshotPath(path));
+        return true;
+    }
+
+    /* Rebuilds DeckStats and the ratings from the newest snapshot and the journal records,
+    which must be those of the run being resumed. Returns the sampler position to resume from */
+    static uint64_t restore(const std::string& path, const std::vector<MatchRecord>& records) {
+        DeckStats::resetResults();
+
+        SnapshotHeader header{};
+        std::vector<DeckRecord> decks;
+        std::ifstream in(snapshotPath(path), std::ios::binary);
+        bool usable = in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            && std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 && header.version == VERSION
+            && header.poolHash == DeckStats::poolHash() && header.deckCount == uint32_t(DeckStats::deckCount())
+            && header.journalRecords <= records.size();
+        if (usable) {
+            decks.resize(header.deckCount);
+            usable = bool(in.read(reinterpret_cast<char*>(decks.data()), decks.size() * sizeof(DeckRecord)));
+        }
+        if (!usable)
+            header = SnapshotHeader{}; // No snapshot: replay the whole journal
+
+        for (ID id = 0; id < ID(decks.size()); id++) {
+            const DeckRecord& deck = decks[id];
+            DeckStats::restoreTotals(id, deck.wins, deck.draws, deck.losses, deck.scoreSum, deck.scoredMatches);
+            DeckStats::restoreElo(id, deck.elo);
+            Glicko::ratings[id] = { deck.mu, deck.phi, deck.sigma };
+        }
+        for (uint64_t i = 0; i < records.size(); i++)
+            if (i < header.journalRecords)
+                DeckStats::restoreMatchup(records[i].redDeck, records[i].blueDeck, records[i].result);
+            else
+                DeckStats::recordMatch(records[i]);
+
+        std::cout << "Journal: resumed " << records.size() << " matches, " << records.size() - header.journalRecords
+            << " replayed after the snapshot" << std::endl;
+        return header.samplerPosition;
+    }
+
+    // Whether path holds a journal to resume. A crash mid-header leaves a file shorter than one, which starts afresh
+    static bool started(const std::string& path) {
+        return std::filesystem::exists(path) && std::filesystem::file_size(path) >= sizeof(Header);
+    }
+
+    // Reads a journal's header and complete records, dropping a trailing partial record from the file
+    static bool read(const std::string& path, Header& header, std::vector<MatchRecord>& records) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            std::cout << "Journal::read() " << path << " is not a journal" << std::endl;
+            return false;
+        }
+
+        ShardFile::Record record;
+        while (in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+            records.push_back(ShardFile::fromRecord(record));
+        in.close();
+
+        const uint64_t validSize = sizeof(Header) + records.size() * sizeof(ShardFile::Record);
+        if (std::filesystem::file_size(path) != validSize)
+            std::filesystem::resize_file(path, validSize);
+        return true;
+    }
+
+    // Replaces the journal at path with the given records, through a synced temporary file
+    static bool rewrite(const std::string& path, const Header& header, const std::vector<MatchRecord>& records) {
+        const std::string temporary = path + ".tmp";
+        FILE* file = openFile(temporary, "wb");
+        if (!file) {
+            std::cout << "Journal::rewrite() could not open " << temporary << std::endl;
+            return false;
+        }
+        std::fwrite(&header, sizeof(header), 1, file);
+        for (const auto& match : records) {
+            const ShardFile::Record record = ShardFile::toRecord(match);
+            std::fwrite(&record, sizeof(record), 1, file);
+        }
+        syncToDisk(file);
+        std::fclose(file);
+        std::filesystem::rename(temporary, path);
+        return true;
+    }
+
+    class Writer {
+    private:
+        FILE* file = nullptr;
+        std::string myPath;
+        Header myHeader{};
+        std::vector<MatchRecord> myRecords;     // Read back on open
+        std::vector<ShardFile::Record> pending;
+        uint64_t synced = 0;
+        std::chrono::steady_clock::time_point lastSync;
+
+    public:
+        Writer() = default;
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        ~Writer() {
+            close();
+        }
+
+        /* Opens the journal at path, reading back the records of an earlier run. A journal
+        for another pool or rules is refused. A resumed run keeps the seed it started with */
+        bool open(const std::string& path, const Header& header) {
+            close();
+            myPath = path;
+            myHeader = header;
+            myRecords.clear();
+
+            const bool resuming = started(path);
+            if (resuming) {
+                Header existing;
+                if (!read(path, existing, myRecords))
+                    return false;
+                if (!existing.sameRun(header)) {
+                    std::cout << "Journal::Writer::open() " << path << " belongs to another deck pool or ruleset" << std::endl;
+                    return false;
+                }
+                myHeader = existing;
+            }
+
+            file = openFile(path, resuming ? "ab" : "wb"); // Truncating drops a torn header
+            if (!file) {
+                std::cout << "Journal::Writer::open() could not open " << path << std::endl;
+                return false;
+            }
+            if (!resuming) {
+                std::fwrite(&myHeader, sizeof(myHeader), 1, file);
+                syncToDisk(file);
+            }
+            synced = myRecords.size();
+            lastSync = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        const std::vector<MatchRecord>& records() const {
+            return myRecords;
+        }
+
+        uint64_t seed() const {
+            return myHeader.seed;
+        }
+
+        // Records in the journal, synced or not
+        uint64_t size() const {
+            return synced + pending.size();
+        }
+
+        void append(const MatchRecord& match) {
+            pending.push_back(ShardFile::toRecord(match));
+            if (pending.size() >= BATCH_RECORDS
+                || std::chrono::duration<double>(std::chrono::steady_clock::now() - lastSync).count() >= BATCH_SECONDS)
+                sync();
+        }
+
+        void sync() {
+            if (!file)
+                return;
+            if (!pending.empty()) {
+                std::fwrite(pending.data(), sizeof(ShardFile::Record), pending.size(), file);
+                syncToDisk(file);
+                synced += pending.size();
+                pending.clear();
+            }
+            lastSync = std::chrono::steady_clock::now();
+        }
+
+        // Syncs, then snapshots DeckStats as covering every journaled record
+        void snapshot(uint64_t samplerPosition) {
+            sync();
+            writeSnapshot(myPath, synced, samplerPosition);
+        }
+
+        void close() {
+            sync();
+            if (file)
+                std::fclose(file);
+            file = nullptr;
+        }
+    };
+}
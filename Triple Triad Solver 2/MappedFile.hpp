@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* A file mapped read-write into memory, so on-disk tables are used in place rather
+than loaded. Opening grows the file to at least the requested size; resize() remaps,
+which invalidates every pointer previously taken from data() */
+class MappedFile {
+private:
+    uint8_t* myData = nullptr;
+    uint64_t mySize = 0;
+    std::string myPath;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    bool map(uint64_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER current;
+        GetFileSizeEx(file, &current);
+        if (uint64_t(current.QuadPart) < size) {
+            LARGE_INTEGER end;
+            end.QuadPart = LONGLONG(size);
+            if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+                return false;
+        }
+        else
+            size = uint64_t(current.QuadPart);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size), nullptr);
+        if (!mapping)
+            return false;
+        myData = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_t(size)));
+        if (!myData)
+            return false;
+#else
+        struct stat status;
+        if (fstat(file, &status) != 0)
+            return false;
+        if (uint64_t(status.st_size) < size) {
+            if (ftruncate(file, off_t(size)) != 0)
+                return false;
+        }
+        else
+            size = uint64_t(status.st_size);
+        void* view = mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (view == MAP_FAILED)
+            return false;
+        myData = static_cast<uint8_t*>(view);
+#endif
+        mySize = size;
+        return true;
+    }
+
+    void unmap() {
+        if (!myData)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(myData);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(myData, size_t(mySize));
+#endif
+        myData = nullptr;
+        mySize = 0;
+    }
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Maps the whole file, creating it or growing it to minimumSize first
+    bool open(const std::string& path, uint64_t minimumSize) {
+        close();
+        myPath = path;
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        const bool opened = file != INVALID_HANDLE_VALUE;
+#else
+        file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        const bool opened = file >= 0;
+#endif
+        if (!opened || !map(minimumSize)) {
+            std::cout << "MappedFile::open() could not map " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Grows the file to size and maps it again
+    bool resize(uint64_t size) {
+        unmap();
+        if (!map(size)) {
+            std::cout << "MappedFile::resize() could not grow " << myPath << " to " << size << " bytes" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Writes dirty pages back to the file
+    void flush() {
+        if (!myData)
+            return;
+#ifdef _WIN32
+        FlushViewOfFile(myData, 0);
+#else
+        msync(myData, size_t(mySize), MS_ASYNC);
+#endif
+    }
+
+    void close() {
+        unmap();
+#ifdef _WIN32
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (file >= 0)
+            ::close(file);
+        file = -1;
+#endif
+    }
+
+    bool isOpen() const {
+        return myData != nullptr;
+    }
+
+    uint8_t* data() {
+        return myData;
+    }
+
+    uint64_t size() const {
+        return mySize;
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "defs.hpp"
+#include <cstdint>
+
+/* One solved match, as produced by tournament workers and merged back afterwards.
+Each deck pair is played twice: leg 0 has the lower ID as RED, leg 1 swaps sides */
+struct MatchRecord {
+    uint64_t matchIndex;    // 2 * DeckPairs index + leg, the canonical merge order
+    ID redDeck;
+    ID blueDeck;
+    Player result;
+    double redScore;        // Swap rule expected score for RED, -1 when the match was solved outright
+    uint64_t nodes;         // Positions the solve visited, for cost scheduling. Not kept in shard files
+
+    // RED's share of the point: 1 win, 0.5 draw, 0 loss, or the Swap expected score
+    double redPoints() const {
+        if (redScore >= 0.0)
+            return redScore;
+        return result == PLAYER_RED ? 1.0 : result == PLAYER_NONE ? 0.5 : 0.0;
+    }
+
+    static uint64_t indexOf(uint64_t pairIndex, int leg) {
+        return 2 * pairIndex + leg;
+    }
+
+    bool operator<(const MatchRecord& other) const {
+        return matchIndex < other.matchIndex;
+    }
+};
+
+/* A recorded game cut down to what batch fits over the whole result set need, 8 bytes.
+Swap rule games hold the result their expected score favours, as DeckStats records it */
+struct GameResult {
+    uint32_t redDeck;
+    uint32_t blueDeck : 30;
+    uint32_t redHalfPoints : 2; // 2 win, 1 draw, 0 loss
+
+    GameResult(ID red, ID blue, Player winner)
+        : redDeck(uint32_t(red)), blueDeck(uint32_t(blue)),
+        redHalfPoints(winner == PLAYER_RED ? 2 : winner == PLAYER_NONE ? 1 : 0) {}
+};
+static_assert(sizeof(GameResult) == 8, "GameResult must stay packed");
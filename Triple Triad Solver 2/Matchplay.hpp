@@ -6,75 +6,178 @@
 #include "CardCollection.hpp"
 #include "Graphics.hpp"
 #include "RenderableCardContainer.hpp"
+#include "PairSampler.hpp"
+#include "MatchRecord.hpp"
+#include "ResultCache.hpp"
+#include "Journal.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 namespace Matchplay {
     static constexpr int MATCHES_TO_PLAY = 84000 * 32;
-    // Check if there are enough decks for the simulation
+    static Rules::Flags activeRules = Rules::NONE; // Capture rules every simulated match is played under
+    static unsigned int solverThreads = std::max(1u, std::thread::hardware_concurrency()); // Workers for batched solves
+    static constexpr int SNAPSHOT_INTERVAL = 1 << 14; // Journaled matches between snapshots of DeckStats
+
+    // Random play draws each deck pair at most once, so it can't exceed the number of pairs
     static bool hasSufficientDecks() {
-        const int sufficientDecks = std::sqrt(MATCHES_TO_PLAY) * 2;
-        if (DeckStats::deckCount() < sufficientDecks) {
-            std::cout << "Error: Not enough decks to satisfy MATCHES_TO_PLAY... OR, will be EXTREMELY slow" << std::endl;
+        const uint64_t pairs = DeckPairs::pairCount(DeckStats::deckCount());
+        if (pairs < MATCHES_TO_PLAY) {
+            std::cout << "Warning: only " << pairs << " deck pairs for MATCHES_TO_PLAY, every pair will be played once" << std::endl;
             return false;
         }
         return true;
     }
 
-    // Select a random matchup and set up the board
-    static void prepareBoard() {
-        Board::init(DeckStats::randomID(), DeckStats::randomID());
-    }
+    /* Swap: before the game one random card from each hand trades sides. All 25 exchanges
+    are solved as one batch, spread over solverThreads workers. Board and transposition table
+    are thread_local, so the batch does not share one table: each worker keeps its own across
+    the variants it takes, and with 25 workers every variant starts from an empty table.
+    The hash covers both hands, so variants meet few common positions and that costs little,
+    about 12% more nodes than the whole batch on one thread. A single table would be probed
+    under a lock by every worker. Returns RED's expected score (1 win, 0.5 draw, 0 loss) */
+    template <typename RuleSet>
+    static double swapExpectedScore(ID redDeck, ID blueDeck, unsigned int threads = solverThreads) {
+        constexpr int VARIANTS = HAND_SIZE * HAND_SIZE;
+        double scores[VARIANTS];
+        std::atomic<int> nextVariant{ 0 };
+        const int roundsLeft = SuddenDeath::roundsLeft; // Per thread, so handed to each worker
+        std::atomic<uint64_t> helperNodes{ 0 };
+
+        auto worker = [&](bool helper) {
+            SuddenDeath::roundsLeft = roundsLeft;
+            transpositionTable.clear();
+            const uint64_t startNodes = Search::nodes;
+            for (int variant = nextVariant++; variant < VARIANTS; variant = nextVariant++) {
+                Board::initSwapped(redDeck, blueDeck, variant / HAND_SIZE, variant % HAND_SIZE);
+                scores[variant] = (Search::expectedValue<RuleSet>() + 1.0) / 2.0;
+            }
+            transpositionTable.clear();
+            if (helper)
+                helperNodes += Search::nodes - startNodes;
+        };
+
+        if (threads <= 1)
+            worker(false); // Already on a tournament worker: solve the batch on this thread
+        else {
+            std::vector<std::thread> workers;
+            for (unsigned int i = 0; i < std::min<unsigned int>(threads, VARIANTS); i++)
+                workers.emplace_back(worker, true);
+            for (auto& thread : workers)
+                thread.join();
+            Search::nodes += helperNodes; // Counted against the calling thread, like an inline batch
+        }
 
-    static void simulateMatch() {
-        auto [result, bestMove] = Search::minimax(0, true);
-        DeckStats::recordMatchResultAndUpdateELO(
-            Board::deck[PLAYER_RED], Board::deck[PLAYER_BLUE], Player(result));
+        double sum = 0.0;
+        for (const double score : scores)
+            sum += score;
+        return sum / VARIANTS;
     }
 
-    static void playAllMatchupsOnce() {
-        const int matchesQueued = DeckStats::deckCount() * (DeckStats::deckCount() - 1);
-        int matchesPlayed = 0;
-        // Loop through every pair of decks once
-        for (int i = 0; i < DeckStats::deckCount(); ++i) {
-            for (int j = i + 1; j < DeckStats::deckCount(); ++j) {
-                // First match: redDeck vs blueDeck
-                Board::init(i, j); // Set the decks as red and blue
-                simulateMatch(); // Simulate the match
-
-                // Second match: blueDeck vs redDeck (swap sides)
-                Board::init(j, i); // Swap the decks for this match
-                simulateMatch(); // Simulate the match
-
-                matchesPlayed += 2;  // Each pair of decks results in 2 matches
-                std::cout << "Match Finished!" << std::endl;
-                Clock::printProgressEveryXseconds(Search::nodes / 100, 1, 3); // Progress tracker
-            }
+    /* Solves one matchup under activeRules, or reads it from the ResultCache when the same
+    cards have met under the same rules before. A cached result visited no nodes. Fresh solves
+    are stored along with a principal variation margin, played out only when the solve ran on
+    this thread alone so its transposition table holds the whole tree. Leaves the unswapped
+    matchup on this thread's board */
+    template <typename RuleSet>
+    static MatchRecord solveMatchup(ID redDeck, ID blueDeck, unsigned int threads = 1) {
+        MatchRecord record{ 0, redDeck, blueDeck, PLAYER_NONE, -1.0, 0 };
+        ResultCache::Entry cached;
+        if (ResultCache::lookup(redDeck, blueDeck, activeRules, cached)) {
+            record.result = Player(cached.result);
+            record.redScore = cached.redScore;
+            Board::init(redDeck, blueDeck);
+            return record;
         }
 
-        std::cout << "Games simulated: " << matchesPlayed << std::endl;
+        const uint64_t startNodes = Search::nodes;
+        const auto start = std::chrono::steady_clock::now();
+        SuddenDeath::roundsLeft = (activeRules & Rules::SUDDEN_DEATH) ? SuddenDeath::roundCap : 0;
+        SuddenDeath::RoundCache<RuleSet>::solved.clear();
+        if (activeRules & Rules::SWAP) {
+            record.redScore = swapExpectedScore<RuleSet>(redDeck, blueDeck, threads);
+            record.result = record.redScore > 0.5 ? PLAYER_RED : record.redScore < 0.5 ? PLAYER_BLUE : PLAYER_NONE;
+            Board::init(redDeck, blueDeck);
+        }
+        else {
+            transpositionTable.clear();
+            Board::init(redDeck, blueDeck);
+            record.result = Search::solveRootParallel<RuleSet>(threads);
+        }
+        record.nodes = Search::nodes - startNodes;
+
+        if (ResultCache::isOpen()) {
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            int margin = ResultCache::MARGIN_UNKNOWN;
+            if (RuleSet::HAND != Rules::CHAOS_HAND && !(activeRules & Rules::SWAP) && threads <= 1)
+                margin = Search::principalVariationMargin<RuleSet>();
+            ResultCache::store(redDeck, blueDeck, activeRules, record.result, record.redScore, margin, record.nodes, seconds);
+        }
+        return record;
     }
 
-    static void playMatchupsRandomly() {
-        if (!hasSufficientDecks()) return;
-
-        int matchesPlayed = 0;
-        while (matchesPlayed < MATCHES_TO_PLAY) {
-            // Prepare the board using a static method from the Board namespace
-            prepareBoard();  // Assuming this method sets up the board
+    // Solves and records the matchup on the board. Swap batches its 25 exchanges over solverThreads
+    template <typename RuleSet = Rules::Basic>
+    static MatchRecord simulateMatch() {
+        const unsigned int threads = (activeRules & Rules::SWAP) ? solverThreads : 1;
+        const MatchRecord match = solveMatchup<RuleSet>(Board::deck[PLAYER_RED], Board::deck[PLAYER_BLUE], threads);
+        DeckStats::recordMatch(match);
+        return match;
+    }
 
-            // Check if the decks have already played against each other
-            if (!DeckStats::hasPlayedAgainst(Board::deck[PLAYER_RED], Board::deck[PLAYER_BLUE])) {
-                // Clear transposition table before starting a new match
-                transpositionTable.clear();
+    // Picks the solver instantiation for activeRules once, up front, rather than per node
+    static MatchRecord simulateMatch() {
+        return Rules::dispatch(activeRules, [](auto ruleset) { return simulateMatch<decltype(ruleset)>(); });
+    }
 
-                // Simulate the match
-                simulateMatch();  // Assuming simulateMatch now uses Board directly
+    /* Plays random unplayed matchups, walking a PairSampler permutation so no pair is drawn
+    twice. Returns the sampler position: passing it back with the same seed resumes the run.
+    With a journal, every result is journaled, matches it already holds count towards
+    MATCHES_TO_PLAY, and DeckStats is snapshotted every SNAPSHOT_INTERVAL matches */
+    static uint64_t playMatchupsRandomly(uint64_t seed, uint64_t position = 0, Journal::Writer* journal = nullptr) {
+        hasSufficientDecks();
+        const int matchesToPlay = int(std::min<uint64_t>(MATCHES_TO_PLAY, DeckPairs::pairCount(DeckStats::deckCount())));
+
+        PairSampler sampler(DeckStats::deckCount(), seed, position);
+        int matchesPlayed = journal ? int(journal->size()) : 0;
+        ID redDeck, blueDeck;
+        while (matchesPlayed < matchesToPlay && sampler.next(redDeck, blueDeck)) {
+            // Pairs can still have met outside this run, e.g. in a round robin or before a resume
+            if (DeckStats::hasPlayedAgainst(redDeck, blueDeck))
+                continue;
 
-                matchesPlayed++;
-                Clock::printProgressEveryXseconds(matchesPlayed, MATCHES_TO_PLAY, 3);
+            transpositionTable.clear();
+            Board::init(redDeck, blueDeck);
+            MatchRecord match = simulateMatch();
+
+            matchesPlayed++;
+            if (journal) {
+                match.matchIndex = MatchRecord::indexOf(DeckPairs::indexOf(redDeck, blueDeck, DeckStats::deckCount()), redDeck > blueDeck);
+                journal->append(match);
+                if (matchesPlayed % SNAPSHOT_INTERVAL == 0)
+                    journal->snapshot(sampler.position());
             }
+            Clock::printProgressEveryXseconds(matchesPlayed, matchesToPlay, 3);
         }
 
+        if (journal)
+            journal->snapshot(sampler.position());
         std::cout << "Games simulated: " << matchesPlayed << std::endl;
+        return sampler.position();
+    }
+
+    /* Random play that survives a crash: resumes the run journaled at path, if there is one,
+    from its last snapshot and journal tail, then plays on. A new journal uses seed */
+    static uint64_t playMatchupsRandomlyJournaled(const std::string& path, uint64_t seed) {
+        Journal::Writer journal;
+        if (!journal.open(path, Journal::makeHeader(seed, activeRules)))
+            return 0;
+        uint64_t position = 0;
+        if (!journal.records().empty())
+            position = Journal::restore(path, journal.records());
+        return playMatchupsRandomly(journal.seed(), position, &journal);
     }
 
     // 1. Create a predefined target deck
@@ -0,0 +1,171 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* The latest result of every pair of decks, 2 bits per pair. The triangle below the
+diagonal is stored row by row, row r holding deck r's results against decks 0 to r - 1,
+so adding a deck only appends a row. A full round robin over 100k decks takes 1.25 GB.
+The matrix can be backed by a memory-mapped scratch file, letting the OS page it out;
+it is rebuilt with the rest of DeckStats, so the file holds nothing that must survive */
+class MatchupMatrix {
+public:
+    enum Cell : uint8_t { UNPLAYED, WIN, DRAW, LOSS }; // From the first deck's side
+
+private:
+    static constexpr uint64_t CELLS_PER_WORD = 32;
+    static constexpr uint64_t LOW_BITS = 0x5555555555555555ull; // The low bit of every cell
+
+    std::vector<uint64_t> memory;
+    MappedFile file;
+    uint64_t* words = nullptr;
+    uint64_t capacity = 0;  // Words available
+    int decks = 0;
+
+    static uint64_t cellsFor(uint64_t deckCount) {
+        return deckCount * (deckCount - (deckCount > 0 ? 1 : 0)) / 2;
+    }
+
+    static uint64_t wordsFor(uint64_t deckCount) {
+        return (cellsFor(deckCount) + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+    }
+
+    // a != b
+    static uint64_t cellOf(ID a, ID b) {
+        const uint64_t high = uint64_t(std::max(a, b)), low = uint64_t(std::min(a, b));
+        return high * (high - 1) / 2 + low;
+    }
+
+    static Cell inverse(Cell cell) {
+        return (cell & 1) ? Cell(cell ^ 2) : cell; // Swaps WIN and LOSS
+    }
+
+    Cell read(uint64_t cell) const {
+        return Cell((words[cell / CELLS_PER_WORD] >> (2 * (cell % CELLS_PER_WORD))) & 3);
+    }
+
+    // Cells in [first, first + count) holding value, a word at a time
+    uint64_t countInRange(uint64_t first, uint64_t count, Cell value) const {
+        const uint64_t pattern = uint64_t(value) * LOW_BITS;
+        uint64_t total = 0;
+        for (uint64_t cell = first, end = first + count; cell < end;) {
+            const uint64_t offset = cell % CELLS_PER_WORD;
+            const uint64_t span = std::min(CELLS_PER_WORD - offset, end - cell);
+            const uint64_t same = ~(words[cell / CELLS_PER_WORD] ^ pattern);
+            const uint64_t lanes = span == CELLS_PER_WORD ? LOW_BITS : ((uint64_t(1) << (2 * span)) - 1) & LOW_BITS;
+            total += popcount64(same & (same >> 1) & (lanes << (2 * offset)));
+            cell += span;
+        }
+        return total;
+    }
+
+    bool reserve(uint64_t wordCount) {
+        if (wordCount <= capacity)
+            return true;
+        if (file.isOpen()) {
+            if (!file.resize(std::max(wordCount, 2 * capacity) * sizeof(uint64_t)))
+                return false;
+            words = reinterpret_cast<uint64_t*>(file.data());
+            capacity = file.size() / sizeof(uint64_t);
+        }
+        else {
+            memory.resize(wordCount);
+            words = memory.data();
+            capacity = memory.size();
+        }
+        return true;
+    }
+
+public:
+    MatchupMatrix() = default;
+    MatchupMatrix(const MatchupMatrix&) = delete;
+    MatchupMatrix& operator=(const MatchupMatrix&) = delete;
+
+    /* Moves the matrix into a memory-mapped file at path, which is overwritten. Returns false,
+    keeping the matrix in memory, if the file can't be mapped */
+    bool map(const std::string& path) {
+        const uint64_t used = wordsFor(decks);
+        if (!file.open(path, std::max<uint64_t>(used, 1) * sizeof(uint64_t)))
+            return false;
+        std::memset(file.data(), 0, size_t(file.size()));
+        if (used > 0)
+            std::memcpy(file.data(), words, size_t(used * sizeof(uint64_t)));
+        words = reinterpret_cast<uint64_t*>(file.data());
+        capacity = file.size() / sizeof(uint64_t);
+        std::vector<uint64_t>().swap(memory);
+        return true;
+    }
+
+    bool isMapped() const {
+        return file.isOpen();
+    }
+
+    // Grows or shrinks to deckCount decks. New pairs start unplayed
+    void resize(int deckCount) {
+        if (deckCount < decks && capacity > 0) { // Cells past the end must read as unplayed when regrown
+            const uint64_t keep = cellsFor(deckCount), end = cellsFor(decks);
+            for (uint64_t cell = keep; cell < end && cell % CELLS_PER_WORD != 0; cell++)
+                words[cell / CELLS_PER_WORD] &= ~(uint64_t(3) << (2 * (cell % CELLS_PER_WORD)));
+            const uint64_t firstWord = (keep + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+            std::fill(words + firstWord, words + wordsFor(decks), 0);
+        }
+        if (!reserve(wordsFor(deckCount))) {
+            std::cout << "MatchupMatrix::resize() could not grow to " << deckCount << " decks" << std::endl;
+            return;
+        }
+        decks = deckCount;
+    }
+
+    // Marks every pair unplayed
+    void clear() {
+        if (words)
+            std::fill(words, words + wordsFor(decks), 0);
+    }
+
+    int deckCount() const {
+        return decks;
+    }
+
+    Cell get(ID deck, ID opponent) const {
+        if (deck == opponent)
+            return UNPLAYED;
+        const Cell cell = read(cellOf(deck, opponent));
+        return deck > opponent ? cell : inverse(cell);
+    }
+
+    void set(ID deck, ID opponent, Cell result) {
+        const uint64_t cell = cellOf(deck, opponent);
+        const uint64_t value = deck > opponent ? result : inverse(result);
+        uint64_t& word = words[cell / CELLS_PER_WORD];
+        const int shift = int(2 * (cell % CELLS_PER_WORD));
+        word = (word & ~(uint64_t(3) << shift)) | (value << shift);
+    }
+
+    bool hasPlayed(ID deck, ID opponent) const {
+        return get(deck, opponent) != UNPLAYED;
+    }
+
+    // Deck's results of value against lower IDs: one contiguous row, counted by popcount
+    uint64_t countInRow(ID deck, Cell value) const {
+        return countInRange(cellOf(deck, 0), uint64_t(deck), value);
+    }
+
+    // Deck's results against every opponent, indexed by Cell
+    void tally(ID deck, uint64_t counts[4]) const {
+        for (int value = WIN; value <= LOSS; value++)
+            counts[value] = countInRow(deck, Cell(value));
+        counts[UNPLAYED] = uint64_t(deck) - counts[WIN] - counts[DRAW] - counts[LOSS];
+        for (ID opponent = deck + 1; opponent < decks; opponent++) // Column cells hold the opponent's side
+            counts[inverse(read(cellOf(opponent, deck)))]++;
+    }
+
+    uint64_t memoryUsage() const {
+        return file.isOpen() ? 0 : memory.capacity() * sizeof(uint64_t);
+    }
+};
@@ -2,14 +2,14 @@
 #include "PossibleMove.hpp"
 
 struct MoveHistory {
-    static std::vector<MoveHistory> moveHistory;
-    static MoveHistory currentMove;  // Static member declaration
+    static thread_local std::vector<MoveHistory> moveHistory;
+    static thread_local MoveHistory currentMove;  // Static member declaration, one per solver thread
 
-    bool flipped[4] = { false, false, false, false };
+    uint16_t flipped = 0; // One bit per board cell, so Combo chains of any length undo in one pass
     PossibleMove move;
 
-    static void addFlip(PossibleMove move, Edge edge) {
-        currentMove.flipped[edge] = true;
+    static void addFlip(int cell) {
+        currentMove.flipped |= uint16_t(1u << cell);
     }
 
     static void finishMove() {
@@ -34,5 +34,5 @@ struct MoveHistory {
 };
 
 // Definition of the static member outside the struct in the header file itself
-std::vector<MoveHistory> MoveHistory::moveHistory;
-MoveHistory MoveHistory::currentMove;
\ No newline at end of file
+thread_local std::vector<MoveHistory> MoveHistory::moveHistory;
+thread_local MoveHistory MoveHistory::currentMove;
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "DeckPairs.hpp"
+#include <cstdint>
+
+/* Visits every deck pair exactly once in a pseudo-random order, with O(1) memory. The
+order is a keyed Feistel permutation over the next even power of two at or above the pair
+count, cycle-walked back into range: a bijection on the pair indexes, so nothing is ever
+drawn twice and no rejection is needed. The position alone is enough to resume a run */
+class PairSampler {
+private:
+    static constexpr int ROUNDS = 4;
+
+    uint64_t domain;    // DeckPairs::pairCount() of the pool
+    uint64_t deckCount;
+    uint64_t seed;
+    uint64_t drawn;     // Pairs handed out so far
+    int halfBits;
+    uint64_t halfMask;
+
+    uint64_t permute(uint64_t value) const {
+        uint64_t left = value >> halfBits;
+        uint64_t right = value & halfMask;
+        for (int round = 0; round < ROUNDS; round++) {
+            const uint64_t next = left ^ (mix64(right ^ mix64(seed + round)) & halfMask);
+            left = right;
+            right = next;
+        }
+        return (left << halfBits) | right;
+    }
+
+public:
+    PairSampler(uint64_t deckCount, uint64_t seed, uint64_t position = 0)
+        : domain(DeckPairs::pairCount(deckCount)), deckCount(deckCount), seed(seed), drawn(position), halfBits(1) {
+        while ((uint64_t(1) << (2 * halfBits)) < domain)
+            halfBits++;
+        halfMask = (uint64_t(1) << halfBits) - 1;
+    }
+
+    // The i-th pair index of the permutation, i < pairCount
+    uint64_t at(uint64_t i) const {
+        uint64_t value = permute(i);
+        while (value >= domain) // Walks at most a few steps: the space is under 4x the domain
+            value = permute(value);
+        return value;
+    }
+
+    bool exhausted() const {
+        return drawn >= domain;
+    }
+
+    uint64_t position() const {
+        return drawn;
+    }
+
+    // Next unplayed pair, with the side each deck takes also chosen by the seed
+    bool next(ID& redDeck, ID& blueDeck) {
+        if (exhausted())
+            return false;
+        const uint64_t pair = at(drawn++);
+        const auto [first, second] = DeckPairs::fromIndex(pair, deckCount);
+        const bool swapSides = mix64(seed ^ ~pair) & 1;
+        redDeck = swapSides ? second : first;
+        blueDeck = swapSides ? first : second;
+        return true;
+    }
+};
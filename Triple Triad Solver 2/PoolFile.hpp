@@ -0,0 +1,73 @@
+#pragma once
+#include "defs.hpp"
+#include "DeckStats.hpp"
+#include "CardCollection.hpp"
+#include "Journal.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* A deck pool written out card by card. Pools are normally regenerated from a seed, but
+the generator draws from the whole card table, so once a patch adds cards the same seed
+gives a different pool. Results that have to outlive a patch keep their pool in a file */
+namespace PoolFile {
+    static constexpr char MAGIC[4] = { 'T', 'T', 'D', 'P' };
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t deckCount;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 16, "Pool file layout must not depend on padding");
+
+    // Replaces any earlier save whole or not at all: --rerate can't work from a torn pool
+    static bool save(const std::string& path) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.deckCount = uint32_t(DeckStats::deckCount());
+        std::vector<int32_t> cards;
+        cards.reserve(size_t(header.deckCount) * DECK_SIZE);
+        for (ID id = 0; id < DeckStats::deckCount(); id++)
+            for (const ID card : DeckStats::deck(id))
+                cards.push_back(card);
+
+        return Journal::replaceFile(path, [&](FILE* file) {
+            return std::fwrite(&header, sizeof(header), 1, file) == 1
+                && std::fwrite(cards.data(), sizeof(int32_t), cards.size(), file) == cards.size();
+        });
+    }
+
+    // Replaces DeckStats' pool with the saved one, keeping deck IDs
+    static bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        Header header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            std::cout << "PoolFile::load() " << path << " is not a deck pool" << std::endl;
+            return false;
+        }
+
+        std::vector<int32_t> cards(size_t(header.deckCount) * DECK_SIZE);
+        if (!in.read(reinterpret_cast<char*>(cards.data()), cards.size() * sizeof(int32_t))) {
+            std::cout << "PoolFile::load() " << path << " is truncated" << std::endl;
+            return false;
+        }
+        for (const int32_t card : cards)
+            if (card <= EMPTY_CARD_ID || card >= CardCollection::cardCount()) {
+                std::cout << "PoolFile::load() " << path << " uses card " << card << ", which no longer exists" << std::endl;
+                return false;
+            }
+
+        DeckStats::clear();
+        for (size_t deck = 0; deck < header.deckCount; deck++)
+            DeckStats::addIfUnique(CardContainer(cards.begin() + deck * DECK_SIZE, cards.begin() + (deck + 1) * DECK_SIZE));
+        return true;
+    }
+}
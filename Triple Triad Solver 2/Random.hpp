@@ -0,0 +1,54 @@
+#pragma once
+#include "helpers.hpp"
+#include <cstdint>
+
+/* Seedable random numbers. Generators are plain values passed to whatever draws from them,
+so nothing shares hidden state between threads and a run is reproduced by its seed alone.
+Parallel work takes one stream per unit of work (never per thread), so results don't
+depend on how many threads shared the work out */
+namespace Random {
+    // xoshiro256**: fast, with a 2^256 - 1 period
+    class Generator {
+    private:
+        uint64_t state[4];
+
+        static uint64_t rotl(uint64_t x, int k) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+    public:
+        // splitmix64 expands the seed, so similar seeds still give unrelated states
+        explicit Generator(uint64_t seed) {
+            for (int i = 0; i < 4; i++) {
+                state[i] = mix64(seed);
+                seed += 0x9E3779B97F4A7C15ull;
+            }
+        }
+
+        uint64_t next() {
+            const uint64_t result = rotl(state[1] * 5, 7) * 9;
+            const uint64_t t = state[1] << 17;
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotl(state[3], 45);
+            return result;
+        }
+
+        // Uniform in [0, bound). Rejects the few values that would bias a plain modulo
+        uint64_t below(uint64_t bound) {
+            const uint64_t threshold = (0 - bound) % bound;
+            uint64_t value = next();
+            while (value < threshold)
+                value = next();
+            return value % bound;
+        }
+    };
+
+    // Generator for unit of work index of a seeded run
+    static Generator stream(uint64_t seed, uint64_t index) {
+        return Generator(mix64(seed ^ mix64(index)));
+    }
+}
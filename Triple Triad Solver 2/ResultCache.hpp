@@ -0,0 +1,299 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "Rules.hpp"
+#include "SuddenDeath.hpp"
+#include "CardCollection.hpp"
+#include "DeckStats.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Solved matchups kept across runs. A matchup's result depends only on the cards in both
+decks and the rules, so entries are keyed by those rather than by deck IDs, and any pool
+sharing matchups with an earlier run gets them back without searching.
+Two files: an append-only log of every entry stored, which is the durable copy, and a
+memory-mapped open-addressing index over it (<path>.index) for O(1) lookups. The index is
+rebuilt from the log whenever the two disagree, e.g. after a crash between the writes.
+Entries also hash the edges and types of their ten cards, so after a card table change
+the matchups it touches read as stale and are solved and stored again */
+namespace ResultCache {
+    static constexpr char LOG_MAGIC[4] = { 'T', 'T', 'R', 'C' };
+    static constexpr char INDEX_MAGIC[4] = { 'T', 'T', 'R', 'I' };
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t MIN_CAPACITY = 1024;  // Index slots, always a power of 2
+    static constexpr int8_t MARGIN_UNKNOWN = INT8_MIN;
+
+    struct Key {
+        uint16_t cards[PLAYER_COUNT][DECK_SIZE]; // Each deck's card IDs, ascending
+        uint32_t rules;                          // rulesetId()
+
+        bool operator==(const Key& other) const {
+            return std::memcmp(this, &other, sizeof(Key)) == 0;
+        }
+    };
+
+    struct Entry {
+        Key key;
+        uint64_t cardsHash;     // Edges and types of the ten cards when the matchup was solved
+        uint64_t nodes;
+        float redScore;         // Swap rule expected score for RED, -1 when solved outright
+        float seconds;          // Wall time of the solve
+        int8_t result;          // Player
+        int8_t margin;          // RED's cards minus BLUE's at the end of a principal variation, or MARGIN_UNKNOWN
+        uint8_t occupied;       // Index slots only
+        uint8_t reserved[5];
+    };
+
+    struct LogHeader {
+        char magic[4];
+        uint32_t version;
+    };
+
+    struct IndexHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t logEntries;    // Log entries indexed; a mismatch with the log triggers a rebuild
+    };
+    static_assert(sizeof(Key) == 24 && sizeof(Entry) == 56 && sizeof(LogHeader) == 8 && sizeof(IndexHeader) == 32,
+        "Result cache layout must not depend on padding");
+
+    static MappedFile index;
+    static std::ofstream log;
+    static std::string logPath;
+    static std::mutex cacheMutex; // Tournament workers share one cache
+    static uint64_t hits = 0, misses = 0;
+
+    // Sudden Death results depend on how many replays are allowed
+    static uint32_t rulesetId(Rules::Flags rules) {
+        return (rules & Rules::SUDDEN_DEATH) ? rules | (uint32_t(SuddenDeath::roundCap) << 16) : rules;
+    }
+
+    static Key makeKey(ID redDeck, ID blueDeck, Rules::Flags rules) {
+        Key key{};
+        const ID decks[PLAYER_COUNT] = { redDeck, blueDeck };
+        for (int player = 0; player < PLAYER_COUNT; player++) {
+            CardContainer cards = DeckStats::deck(decks[player]);
+            std::sort(cards.begin(), cards.end());
+            for (int card = 0; card < DECK_SIZE; card++)
+                key.cards[player][card] = uint16_t(cards[card]);
+        }
+        key.rules = rulesetId(rules);
+        return key;
+    }
+
+    static uint64_t cardsHash(const Key& key) {
+        uint64_t h = 0;
+        for (int player = 0; player < PLAYER_COUNT; player++)
+            for (int card = 0; card < DECK_SIZE; card++) {
+                const Card& stats = CardCollection::card(key.cards[player][card]);
+                for (int edge = 0; edge < 4; edge++)
+                    h = mix64(h ^ uint64_t(stats.attribute(edge)));
+                h = mix64(h ^ uint64_t(stats.type()));
+            }
+        return h;
+    }
+
+    static uint64_t keyHash(const Key& key) {
+        uint64_t h = mix64(key.rules);
+        for (int player = 0; player < PLAYER_COUNT; player++)
+            for (int card = 0; card < DECK_SIZE; card++)
+                h = mix64(h ^ (uint64_t(key.cards[player][card]) << (player * 16)));
+        return h;
+    }
+
+    static IndexHeader& header() {
+        return *reinterpret_cast<IndexHeader*>(index.data());
+    }
+
+    static Entry* slots() {
+        return reinterpret_cast<Entry*>(index.data() + sizeof(IndexHeader));
+    }
+
+    // The slot holding key, or the empty slot it would go in. Linear probing
+    static Entry& slotFor(const Key& key) {
+        const uint64_t mask = header().capacity - 1;
+        for (uint64_t slot = keyHash(key) & mask;; slot = (slot + 1) & mask) {
+            Entry& entry = slots()[slot];
+            if (!entry.occupied || entry.key == key)
+                return entry;
+        }
+    }
+
+    // Empties the index and maps it at the given capacity
+    static bool resetIndex(uint64_t capacity) {
+        if (!index.resize(sizeof(IndexHeader) + capacity * sizeof(Entry)))
+            return false;
+        std::memset(index.data(), 0, size_t(index.size()));
+        std::memcpy(header().magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        header().version = VERSION;
+        header().capacity = capacity;
+        return true;
+    }
+
+    static void insert(const Entry& entry);
+
+    // Doubles the slot count, keeping load under 70%
+    static bool grow() {
+        std::vector<Entry> entries;
+        entries.reserve(size_t(header().count));
+        for (uint64_t slot = 0; slot < header().capacity; slot++)
+            if (slots()[slot].occupied)
+                entries.push_back(slots()[slot]);
+        const uint64_t logEntries = header().logEntries;
+        if (!resetIndex(2 * header().capacity))
+            return false;
+        for (const Entry& entry : entries)
+            insert(entry);
+        header().logEntries = logEntries;
+        return true;
+    }
+
+    // A newer entry for the same key replaces the old one
+    static void insert(const Entry& entry) {
+        if ((header().count + 1) * 10 > header().capacity * 7 && !grow())
+            return;
+        Entry& slot = slotFor(entry.key);
+        if (!slot.occupied)
+            header().count++;
+        slot = entry;
+        slot.occupied = 1;
+    }
+
+    // Reads every complete log entry, dropping a trailing partial one from the file
+    static bool readLog(std::vector<Entry>& entries) {
+        std::ifstream in(logPath, std::ios::binary);
+        LogHeader logHeader;
+        if (!in.read(reinterpret_cast<char*>(&logHeader), sizeof(logHeader))
+            || std::memcmp(logHeader.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || logHeader.version != VERSION) {
+            std::cout << "ResultCache::open() " << logPath << " is not a result cache" << std::endl;
+            return false;
+        }
+
+        Entry entry;
+        while (in.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+            entries.push_back(entry);
+        in.close();
+
+        const uint64_t validSize = sizeof(LogHeader) + entries.size() * sizeof(Entry);
+        if (std::filesystem::file_size(logPath) != validSize)
+            std::filesystem::resize_file(logPath, validSize);
+        return true;
+    }
+
+    static bool isOpen() {
+        return index.isOpen();
+    }
+
+    static void close() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (log.is_open())
+            log.close();
+        index.flush();
+        index.close();
+    }
+
+    // Opens or creates the cache at path. Until then lookups miss and nothing is stored
+    static bool open(const std::string& path) {
+        close();
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        logPath = path;
+        if (!std::filesystem::exists(logPath)) {
+            LogHeader logHeader{};
+            std::memcpy(logHeader.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+            logHeader.version = VERSION;
+            std::ofstream(logPath, std::ios::binary).write(reinterpret_cast<const char*>(&logHeader), sizeof(logHeader));
+        }
+
+        // The index is trusted only if it covers exactly the complete log entries
+        const uint64_t logSize = std::filesystem::file_size(logPath);
+        const uint64_t logEntries = logSize >= sizeof(LogHeader) ? (logSize - sizeof(LogHeader)) / sizeof(Entry) : 0;
+        if (!index.open(path + ".index", sizeof(IndexHeader) + MIN_CAPACITY * sizeof(Entry)))
+            return false;
+        const bool indexValid = std::memcmp(header().magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+            && header().version == VERSION && header().logEntries == logEntries
+            && logSize == sizeof(LogHeader) + logEntries * sizeof(Entry)
+            && index.size() == sizeof(IndexHeader) + header().capacity * sizeof(Entry);
+
+        if (!indexValid) {
+            std::vector<Entry> entries;
+            if (!readLog(entries)) {
+                index.close();
+                return false;
+            }
+            uint64_t capacity = MIN_CAPACITY;
+            while (entries.size() * 10 > capacity * 7)
+                capacity *= 2;
+            if (!resetIndex(capacity)) {
+                index.close();
+                return false;
+            }
+            for (const Entry& entry : entries)
+                insert(entry);
+            header().logEntries = entries.size();
+            std::cout << "ResultCache: rebuilt index over " << entries.size() << " entries" << std::endl;
+        }
+
+        log.open(logPath, std::ios::binary | std::ios::app);
+        if (!log) {
+            std::cout << "ResultCache::open() could not open " << logPath << " for writing" << std::endl;
+            index.close();
+            return false;
+        }
+        hits = misses = 0;
+        return true;
+    }
+
+    // Finds a stored result for the matchup, ignoring entries whose cards have changed since
+    static bool lookup(ID redDeck, ID blueDeck, Rules::Flags rules, Entry& found) {
+        if (!isOpen())
+            return false;
+        const Key key = makeKey(redDeck, blueDeck, rules);
+        const uint64_t hash = cardsHash(key);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        const Entry& slot = slotFor(key);
+        if (slot.occupied && slot.cardsHash == hash) {
+            found = slot;
+            hits++;
+            return true;
+        }
+        misses++;
+        return false;
+    }
+
+    // Appends a solved matchup to the log, then indexes it
+    static void store(ID redDeck, ID blueDeck, Rules::Flags rules, Player result, double redScore,
+        int margin, uint64_t nodes, double seconds) {
+        if (!isOpen())
+            return;
+        Entry entry{};
+        entry.key = makeKey(redDeck, blueDeck, rules);
+        entry.cardsHash = cardsHash(entry.key);
+        entry.nodes = nodes;
+        entry.redScore = float(redScore);
+        entry.seconds = float(seconds);
+        entry.result = int8_t(result);
+        entry.margin = int8_t(margin);
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        log.write(reinterpret_cast<const char*>(&entry), sizeof(entry)).flush();
+        insert(entry);
+        header().logEntries++;
+    }
+
+    static void printStats() {
+        std::cout << "ResultCache: " << hits << " hits, " << misses << " misses";
+        if (isOpen())
+            std::cout << ", " << header().count << " matchups stored";
+        std::cout << std::endl;
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/* Capture rules are compile-time policy classes. Board and Search are templated on a
+ruleset so each combination gets its own specialised code, and the basic ruleset
+compiles down to the plain "higher edge flips" comparison with no rule checks at all */
+namespace Rules {
+    // Edge comparison policies. Values are ranks: 1-9, and A counts as 10
+    namespace Compare {
+        struct Standard {
+            static constexpr bool beats(int attacker, int defender) { return attacker > defender; }
+        };
+
+        struct Reverse {
+            static constexpr bool beats(int attacker, int defender) { return attacker < defender; }
+        };
+
+        // The weakest edge (1) also captures the strongest one (A)
+        struct FallenAce {
+            static constexpr bool beats(int attacker, int defender) {
+                return attacker > defender || (attacker == 1 && defender == 10);
+            }
+        };
+
+        // Under Reverse, A is the weakest edge and captures a 1
+        struct ReverseFallenAce {
+            static constexpr bool beats(int attacker, int defender) {
+                return attacker < defender || (attacker == 10 && defender == 1);
+            }
+        };
+
+        /* Edges are stored as 0-9 or STRENGTH_MAX (255), so the low nibble alone identifies
+        them (A lands on 15). That gives every comparator a 16x16 table indexed without branching */
+        static constexpr int TABLE_SIZE = 16;
+        static constexpr int TABLE_MASK = TABLE_SIZE - 1;
+        static constexpr int ACE_INDEX = 15;
+
+        template <typename Comparator>
+        struct CaptureTable {
+            static constexpr std::array<std::array<bool, TABLE_SIZE>, TABLE_SIZE> build() {
+                std::array<std::array<bool, TABLE_SIZE>, TABLE_SIZE> table{};
+                for (int attacker = 0; attacker < TABLE_SIZE; attacker++)
+                    for (int defender = 0; defender < TABLE_SIZE; defender++) {
+                        const int attackerRank = attacker == ACE_INDEX ? 10 : attacker;
+                        const int defenderRank = defender == ACE_INDEX ? 10 : defender;
+                        table[attacker][defender] = attackerRank >= 1 && attackerRank <= 10
+                            && defenderRank >= 1 && defenderRank <= 10
+                            && Comparator::beats(attackerRank, defenderRank);
+                    }
+                return table;
+            }
+
+            static constexpr std::array<std::array<bool, TABLE_SIZE>, TABLE_SIZE> table = build();
+        };
+
+        // Standard needs no table: raw edge values already order correctly (A is 255)
+        template <typename Comparator>
+        static bool captures(int attacker, int defender) {
+            if constexpr (std::is_same_v<Comparator, Standard>)
+                return attacker > defender;
+            else
+                return CaptureTable<Comparator>::table[attacker & TABLE_MASK][defender & TABLE_MASK];
+        }
+    }
+
+    // Which cards in hand a player may choose from
+    enum HandRule {
+        OPEN_HAND,  // Any card
+        ORDER_HAND, // Only the next card in deck order (ascending card ID, as decks are stored)
+        CHAOS_HAND  // A card chosen at random each turn, searched as a chance node
+    };
+
+    template <bool same, bool plus, typename comparator = Compare::Standard, int typeModifier = 0, HandRule handRule = OPEN_HAND>
+    struct Ruleset {
+        static constexpr bool SAME = same;  // Equal touching edges on 2+ sides flip the enemy cards among them
+        static constexpr bool PLUS = plus;  // Equal touching edge sums on 2+ sides flip the enemy cards among them
+        static constexpr bool COMBO = same || plus; // Cards flipped by Same/Plus go on to capture with the basic rule
+        using Comparator = comparator;      // Decides whether one touching edge captures another
+        static constexpr int TYPE_MODIFIER = typeModifier; // Edge change per same-typed card on the board: +1 Ascension, -1 Descension
+        static constexpr HandRule HAND = handRule;
+    };
+
+    using Basic = Ruleset<false, false>;
+    using Same = Ruleset<true, false>;
+    using Plus = Ruleset<false, true>;
+    using SamePlus = Ruleset<true, true>;
+
+    // Runtime rule selection, resolved into a Ruleset once per match by dispatch()
+    enum Rule : uint32_t {
+        NONE = 0,
+        SAME = 1 << 0,
+        PLUS = 1 << 1,
+        REVERSE = 1 << 2,
+        FALLEN_ACE = 1 << 3,
+        ASCENSION = 1 << 4,
+        DESCENSION = 1 << 5,
+        ORDER = 1 << 6,
+        CHAOS = 1 << 7,
+        SUDDEN_DEATH = 1 << 8, // Match-level: handled by Search::replayDraw(), not part of the Ruleset
+        SWAP = 1 << 9          // Match-level: handled by Matchplay::swapExpectedScore(), not part of the Ruleset
+    };
+    using Flags = uint32_t;
+    static constexpr Flags ALL_RULES = SAME | PLUS | REVERSE | FALLEN_ACE | ASCENSION | DESCENSION | ORDER | CHAOS; // Those a Ruleset encodes
+
+    // Ascension / Descension and Order / Chaos are mutually exclusive pairs
+    static bool isValid(Flags flags) {
+        return !((flags & ASCENSION) && (flags & DESCENSION))
+            && !((flags & ORDER) && (flags & CHAOS));
+    }
+
+    static std::string toString(Flags flags) {
+        if (flags == NONE)
+            return "Basic";
+        std::string name;
+        if (flags & SAME) name += "Same+";
+        if (flags & PLUS) name += "Plus+";
+        if (flags & REVERSE) name += "Reverse+";
+        if (flags & FALLEN_ACE) name += "FallenAce+";
+        if (flags & ASCENSION) name += "Ascension+";
+        if (flags & DESCENSION) name += "Descension+";
+        if (flags & ORDER) name += "Order+";
+        if (flags & CHAOS) name += "Chaos+";
+        if (flags & SUDDEN_DEATH) name += "SuddenDeath+";
+        if (flags & SWAP) name += "Swap+";
+        name.pop_back();
+        return name;
+    }
+
+    template <bool same, bool plus, typename Comparator, int typeModifier, typename F>
+    static auto dispatchHand(Flags flags, F&& f) {
+        if (flags & ORDER)
+            return f(Ruleset<same, plus, Comparator, typeModifier, ORDER_HAND>());
+        if (flags & CHAOS)
+            return f(Ruleset<same, plus, Comparator, typeModifier, CHAOS_HAND>());
+        return f(Ruleset<same, plus, Comparator, typeModifier, OPEN_HAND>());
+    }
+
+    template <bool same, bool plus, typename Comparator, typename F>
+    static auto dispatchModifier(Flags flags, F&& f) {
+        if (flags & ASCENSION)
+            return dispatchHand<same, plus, Comparator, 1>(flags, f);
+        if (flags & DESCENSION)
+            return dispatchHand<same, plus, Comparator, -1>(flags, f);
+        return dispatchHand<same, plus, Comparator, 0>(flags, f);
+    }
+
+    template <bool same, bool plus, typename F>
+    static auto dispatchComparator(Flags flags, F&& f) {
+        if ((flags & REVERSE) && (flags & FALLEN_ACE))
+            return dispatchModifier<same, plus, Compare::ReverseFallenAce>(flags, f);
+        if (flags & REVERSE)
+            return dispatchModifier<same, plus, Compare::Reverse>(flags, f);
+        if (flags & FALLEN_ACE)
+            return dispatchModifier<same, plus, Compare::FallenAce>(flags, f);
+        return dispatchModifier<same, plus, Compare::Standard>(flags, f);
+    }
+
+    // Calls f with a default-constructed Ruleset matching the flags, e.g.
+    // dispatch(flags, [](auto ruleset) { return Search::solve<decltype(ruleset)>(); });
+    template <typename F>
+    static auto dispatch(Flags flags, F&& f) {
+        if ((flags & SAME) && (flags & PLUS))
+            return dispatchComparator<true, true>(flags, f);
+        if (flags & SAME)
+            return dispatchComparator<true, false>(flags, f);
+        if (flags & PLUS)
+            return dispatchComparator<false, true>(flags, f);
+        return dispatchComparator<false, false>(flags, f);
+    }
+}
@@ -2,60 +2,237 @@
 #include "defs.hpp"
 #include "TranspositionTable.hpp"
 #include "Board.hpp"
+#include "SuddenDeath.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
 
 namespace Search {
+    static thread_local uint64_t nodes = 0; // Positions visited by this thread, for progress reporting and benchmarks
+
+    template <typename RuleSet>
+    static SuddenDeath::RoundValue<RuleSet> replayDraw();
+
+    template <typename RuleSet>
+    static double expectimax();
+
+    template <typename RuleSet = Rules::Basic>
+    static Player solve();
+
+    // Whoever an expected score for RED favours
+    static Player favouredPlayer(double expected) {
+        return expected > 0.0 ? PLAYER_RED : expected < 0.0 ? PLAYER_BLUE : PLAYER_NONE;
+    }
+
+    template <typename RuleSet = Rules::Basic>
     static Player alphaBeta(Player maximizingPlayer, int depth = 1) {
-        int boardHash = Board::hash();  // Compute hash before move
+        nodes++;
+        uint64_t boardHash = Board::hash();  // Compute hash before move
         auto it = transpositionTable.find(boardHash);
         if (it != transpositionTable.end() && it->second.depth >= depth)
             return it->second.result;  // Use cached result if available at sufficient depth
-        if (Board::matchEnded())
-            return Board::winningPlayer();  // Returns PLAYER_RED, PLAYER_BLUE, or PLAYER_NONE
+        if (Board::matchEnded()) {
+            const Player winner = Board::winningPlayer();  // Returns PLAYER_RED, PLAYER_BLUE, or PLAYER_NONE
+            if (winner == PLAYER_NONE && SuddenDeath::roundsLeft > 0) {
+                if constexpr (RuleSet::HAND == Rules::CHAOS_HAND)
+                    return favouredPlayer(replayDraw<RuleSet>());
+                else
+                    return replayDraw<RuleSet>();  // Under Sudden Death a draw is worth whatever the replay is worth
+            }
+            return winner;
+        }
         Player bestOutcome = (maximizingPlayer == PLAYER_RED) ? PLAYER_BLUE : PLAYER_RED;  // Worst case scenario
-        const auto possibleMoves = Board::getAllPossibleMoves();
+        const auto possibleMoves = Board::getAllPossibleMoves<RuleSet>();
         for (const auto& move : possibleMoves) {
-            Board::makeMove(move);  // Apply move
-            Player eval = alphaBeta((maximizingPlayer == PLAYER_RED) ? PLAYER_BLUE : PLAYER_RED, depth + 1);
-            Board::undoMove();  // Undo move after recursion
+            Board::makeMove<RuleSet>(move);  // Apply move
+            Player eval = alphaBeta<RuleSet>((maximizingPlayer == PLAYER_RED) ? PLAYER_BLUE : PLAYER_RED, depth + 1);
+            Board::undoMove<RuleSet>();  // Undo move after recursion
             // Recompute hash in case flipping affected state
             boardHash = Board::hash();
 
             // Maximizing Player (RED)
-            if (maximizingPlayer == PLAYER_RED)
+            if (maximizingPlayer == PLAYER_RED) {
                 if (eval == PLAYER_RED) {
                     transpositionTable[boardHash] = { PLAYER_RED, depth };
                     return PLAYER_RED;  // Immediate win, prune further
                 }
-                if (eval == PLAYER_NONE) bestOutcome = PLAYER_NONE;
+            }
             // Minimizing Player (BLUE)
-            else
-                if (eval == PLAYER_BLUE) {
-                    transpositionTable[boardHash] = { PLAYER_BLUE, depth };
-                    return PLAYER_BLUE;  // Immediate win for opponent, prune
-                }
-                if (eval == PLAYER_NONE) bestOutcome = PLAYER_NONE;
+            else if (eval == PLAYER_BLUE) {
+                transpositionTable[boardHash] = { PLAYER_BLUE, depth };
+                return PLAYER_BLUE;  // Immediate win for opponent, prune
+            }
+            if (eval == PLAYER_NONE) bestOutcome = PLAYER_NONE;
         }
         transpositionTable[boardHash] = { bestOutcome, depth };
         return bestOutcome;
     }
 
+    /* Solves the Sudden Death replay of the drawn game on the board, then puts that game back.
+    Under Chaos the replay's expected score is kept, so a chance layer averages it unrounded */
+    template <typename RuleSet>
+    static SuddenDeath::RoundValue<RuleSet> replayDraw() {
+        const CardContainer redHand = Board::ownedCards(PLAYER_RED);
+        const CardContainer blueHand = Board::ownedCards(PLAYER_BLUE);
+        const Player firstPlayer = otherPlayer(Board::startingPlayer);
+        const SuddenDeath::RoundKey key = SuddenDeath::makeKey(redHand, blueHand, firstPlayer, SuddenDeath::roundsLeft - 1);
+
+        auto& solvedRounds = SuddenDeath::RoundCache<RuleSet>::solved;
+        auto it = solvedRounds.find(key);
+        if (it != solvedRounds.end())
+            return it->second;
+
+        // The replay gets its own transposition table: its positions can match the outer game's
+        // while having fewer rounds left to resolve a draw
+        const Board::Snapshot outerGame = Board::save();
+        std::unordered_map<uint64_t, TranspositionEntry> outerTable;
+        outerTable.swap(transpositionTable);
+        SuddenDeath::roundsLeft--;
+
+        Board::initWithHands(redHand, blueHand, firstPlayer);
+        SuddenDeath::RoundValue<RuleSet> result;
+        if constexpr (RuleSet::HAND == Rules::CHAOS_HAND)
+            result = expectimax<RuleSet>();
+        else
+            result = solve<RuleSet>();
+
+        SuddenDeath::roundsLeft++;
+        transpositionTable.swap(outerTable);
+        Board::restore(outerGame);
+
+        SuddenDeath::RoundCache<RuleSet>::store(key, result);
+        return result;
+    }
+
+    static double outcomeValue(Player winner) {
+        return winner == PLAYER_RED ? 1.0 : winner == PLAYER_BLUE ? -1.0 : 0.0;
+    }
+
+    /* Chaos: the card to play is drawn at random, then its owner picks the cell. Each turn
+    is a chance layer averaging over the cards in hand above a max/min layer over the cells,
+    and the transposition table stores the expected score for RED */
+    template <typename RuleSet>
+    static double expectimax() {
+        nodes++;
+        const uint64_t boardHash = Board::hash();
+        auto it = transpositionTable.find(boardHash);
+        if (it != transpositionTable.end())
+            return it->second.value;
+        if (Board::matchEnded()) {
+            const Player winner = Board::winningPlayer();
+            if (winner == PLAYER_NONE && SuddenDeath::roundsLeft > 0)
+                return replayDraw<RuleSet>(); // Worth the replay's expected score
+            return outcomeValue(winner);
+        }
+
+        const Player mover = Board::currentPlayer;
+        const CardContainer forcedCards = Board::hand[mover]; // Copied, the hand changes as moves are made
+        double expected = 0.0;
+        for (const ID card : forcedCards) {
+            double best = (mover == PLAYER_RED) ? -1.0 : 1.0; // Worst case for the mover
+            for (const auto& move : Board::getMovesForCard(card)) {
+                Board::makeMove<RuleSet>(move);
+                const double eval = expectimax<RuleSet>();
+                Board::undoMove<RuleSet>();
+                best = (mover == PLAYER_RED) ? std::max(best, eval) : std::min(best, eval);
+            }
+            expected += best;
+        }
+        expected /= forcedCards.size();
+
+        transpositionTable[boardHash] = { PLAYER_NONE, 0, expected };
+        return expected;
+    }
+
+    // Expected score for RED of the position on the board: exact (+1/0/-1) unless Chaos is active
+    template <typename RuleSet = Rules::Basic>
+    static double expectedValue() {
+        if constexpr (RuleSet::HAND == Rules::CHAOS_HAND)
+            return expectimax<RuleSet>();
+        else
+            return outcomeValue(alphaBeta<RuleSet>(Board::currentPlayer));
+    }
+
+    // Solves the position currently on the board under the given ruleset.
+    // Under Chaos the result is whoever the expected score favours
+    template <typename RuleSet>
+    static Player solve() {
+        if constexpr (RuleSet::HAND == Rules::CHAOS_HAND) {
+            return favouredPlayer(expectimax<RuleSet>());
+        }
+        else
+            return alphaBeta<RuleSet>(Board::currentPlayer);
+    }
+
+    /* Splits one solve across threads at the root, for positions expensive enough to hold up
+    everything else. Workers take root moves from a shared counter and solve each child on
+    their own board and table, stopping once any move wins for the side to move. Nodes the
+    helper threads visit are added to the caller's count */
+    template <typename RuleSet>
+    static Player solveRootParallel(unsigned int threads) {
+        if constexpr (RuleSet::HAND == Rules::CHAOS_HAND)
+            return solve<RuleSet>(); // The root is a chance node: its value needs every branch anyway
+        else {
+            if (threads <= 1 || Board::matchEnded())
+                return solve<RuleSet>();
+
+            const Board::Snapshot root = Board::save();
+            const Player mover = Board::currentPlayer;
+            const auto possibleMoves = Board::getAllPossibleMoves<RuleSet>();
+            const int roundsLeft = SuddenDeath::roundsLeft;
+            std::atomic<size_t> nextMove{ 0 };
+            std::atomic<bool> moverWins{ false }, drawFound{ false };
+            std::atomic<uint64_t> helperNodes{ 0 };
+
+            auto worker = [&](bool helper) {
+                if (helper) {
+                    Board::restore(root);
+                    SuddenDeath::roundsLeft = roundsLeft;
+                }
+                const uint64_t startNodes = nodes;
+                for (size_t i = nextMove++; i < possibleMoves.size() && !moverWins; i = nextMove++) {
+                    Board::makeMove<RuleSet>(possibleMoves[i]);
+                    const Player eval = alphaBeta<RuleSet>(otherPlayer(mover), 2);
+                    Board::undoMove<RuleSet>();
+                    if (eval == mover)
+                        moverWins = true;
+                    else if (eval == PLAYER_NONE)
+                        drawFound = true;
+                }
+                if (helper)
+                    helperNodes += nodes - startNodes;
+            };
+
+            std::vector<std::thread> helpers;
+            for (unsigned int i = 1; i < std::min<size_t>(threads, possibleMoves.size()); i++)
+                helpers.emplace_back(worker, true);
+            worker(false);
+            for (auto& thread : helpers)
+                thread.join();
+
+            nodes += helperNodes;
+            return moverWins ? mover : drawFound ? PLAYER_NONE : otherPlayer(mover);
+        }
+    }
+
+    template <typename RuleSet = Rules::Basic>
     static PossibleMove findBestMove() {
         Player currentPlayer = Board::currentPlayer;
         Player bestOutcome = (currentPlayer == PLAYER_RED) ? PLAYER_BLUE : PLAYER_RED;  // Assume worst case
         PossibleMove bestMove;  // Variable to store the best move found
-        const auto possibleMoves = Board::getAllPossibleMoves();  // Get all possible moves for the current player
+        const auto possibleMoves = Board::getAllPossibleMoves<RuleSet>();  // Get all possible moves for the current player
 
         for (const auto& move : possibleMoves) {
             // Apply the move to the board
-            Board::makeMove(move);
+            Board::makeMove<RuleSet>(move);
 
             // Evaluate the position using the alpha-beta search for the opponent's turn
-            Player eval = alphaBeta((currentPlayer == PLAYER_RED) ? PLAYER_BLUE : PLAYER_RED);
+            Player eval = alphaBeta<RuleSet>((currentPlayer == PLAYER_RED) ? PLAYER_BLUE : PLAYER_RED);
 
             // If the move results in a win for the current player, return the best move directly
             if (eval == currentPlayer) {
                 bestMove = move;
-                Board::undoMove();  // Revert the move after evaluation
+                Board::undoMove<RuleSet>();  // Revert the move after evaluation
                 return bestMove;  // Return the winning move
             }
             // If a draw is found and its better than a loss, prefer a draw over a loss
@@ -64,15 +241,30 @@ namespace Search {
                 bestMove = move;
             }
             // If we havent found a winning or drawing move, update the worst-case scenario
-            else if (bestOutcome != currentPlayer && eval != currentPlayer) {
+            else if (bestOutcome != PLAYER_NONE) { // A loss, kept only until a draw turns up
                 bestMove = move;
             }
 
             // Undo the move after the evaluation is done
-            Board::undoMove();
+            Board::undoMove<RuleSet>();
         }
 
         // Return the best move found after evaluating all possibilities
         return bestMove;
     }
+
+    /* Plays the position out along findBestMove() and returns RED's cards minus BLUE's at the
+    end, leaving the board as it was. Solving only separates win, draw and loss, so this is the
+    margin of one optimal line rather than the widest one. Run it right after solve() on the
+    same thread, while the transposition table still holds the tree */
+    template <typename RuleSet = Rules::Basic>
+    static int principalVariationMargin() {
+        int movesPlayed = 0;
+        for (; !Board::matchEnded(); movesPlayed++)
+            Board::makeMove<RuleSet>(findBestMove<RuleSet>());
+        const int margin = int(Board::ownedCards(PLAYER_RED).size()) - int(Board::ownedCards(PLAYER_BLUE).size());
+        for (; movesPlayed > 0; movesPlayed--)
+            Board::undoMove<RuleSet>();
+        return margin;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+#include "defs.hpp"
+#include "MatchRecord.hpp"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Binary result file of one tournament shard: a fixed header naming the deck pool and
+shard, followed by one fixed-size record per solved match, appended as they finish.
+A shard killed mid-write leaves at most one partial record, which reopening truncates */
+namespace ShardFile {
+    static constexpr char MAGIC[4] = { 'T', 'T', 'S', 'R' };
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t seed;          // Deck pool seed
+        uint64_t poolHash;      // DeckStats::poolHash() of the pool the shard was solved against
+        uint32_t deckCount;
+        uint32_t rules;         // Rules::Flags
+        uint32_t shardIndex;
+        uint32_t shardCount;
+
+        // Same pool and rules, whichever shard
+        bool sameTournament(const Header& other) const {
+            return seed == other.seed && poolHash == other.poolHash
+                && deckCount == other.deckCount && rules == other.rules;
+        }
+    };
+
+    // On-disk MatchRecord with explicit widths and no padding
+    struct Record {
+        uint64_t matchIndex;
+        int32_t redDeck;
+        int32_t blueDeck;
+        int32_t result;
+        int32_t reserved;
+        double redScore;
+    };
+    static_assert(sizeof(Header) == 40 && sizeof(Record) == 32, "Shard file layout must not depend on padding");
+
+    static Header makeHeader(uint64_t seed, uint64_t poolHash, uint32_t deckCount, uint32_t rules,
+        uint32_t shardIndex, uint32_t shardCount) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.seed = seed;
+        header.poolHash = poolHash;
+        header.deckCount = deckCount;
+        header.rules = rules;
+        header.shardIndex = shardIndex;
+        header.shardCount = shardCount;
+        return header;
+    }
+
+    static Record toRecord(const MatchRecord& match) {
+        return { match.matchIndex, int32_t(match.redDeck), int32_t(match.blueDeck), int32_t(match.result), 0, match.redScore };
+    }
+
+    static MatchRecord fromRecord(const Record& record) {
+        return { record.matchIndex, ID(record.redDeck), ID(record.blueDeck), Player(record.result), record.redScore };
+    }
+
+    // Whether path holds a shard to resume. A crash mid-header leaves a file shorter than one, which starts afresh
+    static bool started(const std::string& path) {
+        return std::filesystem::exists(path) && std::filesystem::file_size(path) >= sizeof(Header);
+    }
+
+    // Reads a shard's header and complete records, dropping a trailing partial record from the file
+    static bool read(const std::string& path, Header& header, std::vector<MatchRecord>& records) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            std::cout << "ShardFile::read() " << path << " is not a shard file" << std::endl;
+            return false;
+        }
+
+        Record record;
+        uint64_t complete = 0;
+        while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            records.push_back(fromRecord(record));
+            complete++;
+        }
+        in.close();
+
+        const uint64_t validSize = sizeof(Header) + complete * sizeof(Record);
+        if (std::filesystem::file_size(path) != validSize)
+            std::filesystem::resize_file(path, validSize);
+        return true;
+    }
+
+    // Appends records as matches finish, creating the file and header if needed
+    class Writer {
+    private:
+        std::ofstream out;
+
+    public:
+        bool open(const std::string& path, const Header& header) {
+            const bool resuming = started(path);
+            out.open(path, std::ios::binary | (resuming ? std::ios::app : std::ios::trunc)); // Truncating drops a torn header
+            if (!out) {
+                std::cout << "ShardFile::Writer::open() could not open " << path << std::endl;
+                return false;
+            }
+            if (!resuming)
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header)).flush();
+            return true;
+        }
+
+        void append(const MatchRecord& match) {
+            const Record record = toRecord(match);
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record)).flush();
+        }
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "defs.hpp"
+#include "helpers.hpp"
+#include "Rules.hpp"
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+#include <type_traits>
+
+/* Under Sudden Death a drawn game is replayed, each player taking the cards they owned
+at the end of it. Search treats a draw as the value of that next round, and the rounds
+solved along the way are cached here so repeated replays are looked up, not re-solved */
+namespace SuddenDeath {
+    static int roundCap = 3;    // Replays allowed after the first game before a draw stands
+    static thread_local int roundsLeft = 0;  // Replays still allowed in the game being searched; 0 when the rule is off
+
+    struct RoundKey {
+        std::array<ID, HAND_SIZE> hands[PLAYER_COUNT];
+        Player firstPlayer;
+        int roundsLeft; // A replay with fewer rounds to go may resolve differently
+
+        bool operator==(const RoundKey& other) const {
+            return hands[PLAYER_RED] == other.hands[PLAYER_RED] && hands[PLAYER_BLUE] == other.hands[PLAYER_BLUE]
+                && firstPlayer == other.firstPlayer && roundsLeft == other.roundsLeft;
+        }
+    };
+
+    struct RoundKeyHasher {
+        size_t operator()(const RoundKey& key) const {
+            uint64_t h = mix64(uint64_t(key.firstPlayer) | (uint64_t(key.roundsLeft) << 8));
+            for (int player = 0; player < PLAYER_COUNT; player++)
+                for (int card = 0; card < HAND_SIZE; card++)
+                    h = mix64(h ^ uint64_t(key.hands[player][card]));
+            return size_t(h);
+        }
+    };
+
+    // What a solved round is worth: its result, or under Chaos the expected score for RED
+    template <typename RuleSet>
+    using RoundValue = std::conditional_t<RuleSet::HAND == Rules::CHAOS_HAND, double, Player>;
+
+    /* One cache per ruleset instantiation and solver thread. Solving a match clears it first,
+    as helper threads start empty on every match anyway, so it holds one match's rounds and
+    at most ROUND_CACHE_LIMIT of those: about 90 bytes each, some 6 MB per thread */
+    static constexpr size_t ROUND_CACHE_LIMIT = 1 << 16;
+
+    template <typename RuleSet>
+    struct RoundCache {
+        inline static thread_local std::unordered_map<RoundKey, RoundValue<RuleSet>, RoundKeyHasher> solved;
+
+        // Once full, rounds already cached stay and new ones are solved each time they come up
+        static void store(const RoundKey& key, RoundValue<RuleSet> value) {
+            if (solved.size() < ROUND_CACHE_LIMIT)
+                solved.emplace(key, value);
+        }
+    };
+
+    // A draw always splits the 10 cards 5-5, so both replay hands are full
+    static RoundKey makeKey(CardContainer redHand, CardContainer blueHand, Player firstPlayer, int roundsLeft) {
+        RoundKey key{};
+        std::sort(redHand.begin(), redHand.end());
+        std::sort(blueHand.begin(), blueHand.end());
+        std::copy_n(redHand.begin(), HAND_SIZE, key.hands[PLAYER_RED].begin());
+        std::copy_n(blueHand.begin(), HAND_SIZE, key.hands[PLAYER_BLUE].begin());
+        key.firstPlayer = firstPlayer;
+        key.roundsLeft = roundsLeft;
+        return key;
+    }
+}
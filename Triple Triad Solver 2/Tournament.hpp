@@ -0,0 +1,762 @@
+#pragma once
+#include "defs.hpp"
+#include "DeckPairs.hpp"
+#include "MatchRecord.hpp"
+#include "DeckStats.hpp"
+#include "Board.hpp"
+#include "Search.hpp"
+#include "Matchplay.hpp"
+#include "Clock.hpp"
+#include "ShardFile.hpp"
+#include "CostModel.hpp"
+#include "DeckSignature.hpp"
+#include "Journal.hpp"
+#include "CardTable.hpp"
+#include "PoolFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* Round-robin tournaments solved on a pool of threads. Solver state is thread_local, so
+each worker solves matches independently into its own buffer. ELO updates depend on order,
+so buffers are merged by match index and replayed into DeckStats only once every match is
+in: the ratings come out bit-identical whatever the thread count */
+namespace Tournament {
+    static constexpr double OUTLIER_FACTOR = 16.0; // Predicted cost over the median at which a solve is split across threads
+    static constexpr int POOL_BLOCK = 256;          // Candidate decks drawn per random stream by generatePool()
+
+    // Decks of one leg of a deck pair, RED first
+    static std::pair<ID, ID> matchDecks(uint64_t matchIndex) {
+        const auto [first, second] = DeckPairs::fromIndex(matchIndex / 2, DeckStats::deckCount());
+        return matchIndex % 2 == 0 ? std::make_pair(first, second) : std::make_pair(second, first);
+    }
+
+    // Solves one leg of a deck pair on the calling thread's board, split over threads if more than one
+    template <typename RuleSet>
+    static MatchRecord solveMatch(uint64_t matchIndex, unsigned int threads = 1) {
+        const auto [redDeck, blueDeck] = matchDecks(matchIndex);
+        MatchRecord record = Matchplay::solveMatchup<RuleSet>(redDeck, blueDeck, threads);
+        record.matchIndex = matchIndex;
+        return record;
+    }
+
+    /* Solve times vary by orders of magnitude between matchups, so work is handed out
+    longest-predicted-first and the run doesn't end on one core grinding a late monster.
+    The CostModel predictor learns from every finished solve, and the queue is re-ranked
+    whenever the number of solves doubles. Predicted outliers are solved first, one at a
+    time with every thread splitting them at the root */
+    struct ScheduledMatch {
+        uint64_t matchIndex;    // Solved for its whole signature group
+        size_t group;
+        CostModel::Features features;
+        double predictedLogNodes;
+    };
+
+    static void rankByPredictedCost(std::vector<ScheduledMatch>& queue, const CostModel::Predictor& predictor) {
+        for (auto& match : queue)
+            match.predictedLogNodes = predictor.predictLogNodes(match.features);
+        // Cheapest first, so workers pop the most expensive off the back
+        std::sort(queue.begin(), queue.end(), [](const ScheduledMatch& a, const ScheduledMatch& b) {
+            return a.predictedLogNodes != b.predictedLogNodes ? a.predictedLogNodes < b.predictedLogNodes : a.matchIndex > b.matchIndex;
+        });
+    }
+
+    // onSolved, if given, sees each match as it finishes (serialised, in completion order)
+    template <typename RuleSet>
+    static std::vector<MatchRecord> solveMatches(const std::vector<uint64_t>& matchIndexes, unsigned int threads,
+        const std::function<void(const MatchRecord&)>& onSolved = nullptr) {
+        threads = std::max(1u, std::min<unsigned int>(threads, matchIndexes.size()));
+        const auto start = std::chrono::steady_clock::now();
+
+        /* Matches between the same pair of deck signatures share a result: solve one per group.
+        Signatures are assigned afresh each call, since the pool, the rules or the card table
+        may all have changed since the last; it is one pass over the decks */
+        const std::vector<uint32_t> signatures = DeckSignature::assign(Matchplay::activeRules);
+        std::unordered_map<uint64_t, size_t> groupOf;
+        std::vector<std::vector<uint64_t>> groups;
+        CostModel::Predictor predictor;
+        std::vector<ScheduledMatch> queue;
+        for (const uint64_t matchIndex : matchIndexes) {
+            const auto [redDeck, blueDeck] = matchDecks(matchIndex);
+            const uint64_t key = (uint64_t(signatures[redDeck]) << 32) | signatures[blueDeck];
+            const auto [it, added] = groupOf.emplace(key, groups.size());
+            if (added) {
+                groups.emplace_back();
+                queue.push_back({ matchIndex, it->second, CostModel::features(redDeck, blueDeck), 0.0 });
+            }
+            groups[it->second].push_back(matchIndex);
+        }
+        if (queue.size() < matchIndexes.size())
+            std::cout << "Stat signatures: solving " << queue.size() << " of " << matchIndexes.size() << " matches ("
+                << std::fixed << std::setprecision(1) << 100.0 * (matchIndexes.size() - queue.size()) / matchIndexes.size()
+                << "% saved)" << std::endl;
+        rankByPredictedCost(queue, predictor);
+
+        std::vector<std::vector<MatchRecord>> buffers(threads);
+        std::mutex scheduleMutex; // Guards queue, predictor and onSolved
+        size_t matchesSolved = 0, solves = 0;
+        size_t nextRerank = 1;
+
+        // Fans the result out to the match's signature group. Returns the number of matches solved so far
+        const auto finished = [&](const ScheduledMatch& match, const MatchRecord& solved, unsigned int id) {
+            std::lock_guard<std::mutex> lock(scheduleMutex);
+            if (solved.nodes > 0) // Cache hits say nothing about solve cost
+                predictor.observe(match.features, solved.nodes);
+            for (const uint64_t matchIndex : groups[match.group]) {
+                MatchRecord record = solved;
+                record.matchIndex = matchIndex;
+                std::tie(record.redDeck, record.blueDeck) = matchDecks(matchIndex);
+                record.nodes = matchIndex == match.matchIndex ? solved.nodes : 0;
+                buffers[id].push_back(record);
+                if (onSolved)
+                    onSolved(record);
+            }
+            matchesSolved += groups[match.group].size();
+            if (++solves == nextRerank) {
+                rankByPredictedCost(queue, predictor);
+                nextRerank *= 2;
+            }
+            return matchesSolved;
+        };
+
+        // Outliers: everything predicted far above the median, most expensive first
+        if (threads > 1 && !queue.empty()) {
+            const double outlierLogNodes = queue[queue.size() / 2].predictedLogNodes + std::log(OUTLIER_FACTOR);
+            while (!queue.empty() && queue.back().predictedLogNodes > outlierLogNodes) {
+                const ScheduledMatch match = queue.back();
+                queue.pop_back();
+                finished(match, solveMatch<RuleSet>(match.matchIndex, threads), 0);
+            }
+        }
+
+        std::chrono::steady_clock::time_point firstIdle{};
+        auto worker = [&](unsigned int id) {
+            while (true) {
+                ScheduledMatch match;
+                {
+                    std::lock_guard<std::mutex> lock(scheduleMutex);
+                    if (queue.empty()) {
+                        if (firstIdle == std::chrono::steady_clock::time_point{})
+                            firstIdle = std::chrono::steady_clock::now();
+                        break;
+                    }
+                    match = queue.back();
+                    queue.pop_back();
+                }
+                const size_t solvedSoFar = finished(match, solveMatch<RuleSet>(match.matchIndex), id);
+                if (id == 0) // Clock isn't thread safe, so only the calling thread reports
+                    Clock::printProgressEveryXseconds(float(solvedSoFar), float(matchIndexes.size()), 3);
+            }
+            transpositionTable.clear();
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned int id = 1; id < threads; id++)
+            workers.emplace_back(worker, id);
+        worker(0);
+        for (auto& thread : workers)
+            thread.join();
+
+        // Tail: from the first worker running dry to the last match finishing
+        const auto end = std::chrono::steady_clock::now();
+        if (threads > 1 && firstIdle != std::chrono::steady_clock::time_point{})
+            std::cout << "Solved " << matchIndexes.size() << " matches in "
+                << std::chrono::duration<double>(end - start).count() << "s, tail "
+                << std::chrono::duration<double>(end - firstIdle).count() << "s" << std::endl;
+
+        std::vector<MatchRecord> records;
+        records.reserve(matchIndexes.size());
+        for (const auto& buffer : buffers)
+            records.insert(records.end(), buffer.begin(), buffer.end());
+        std::sort(records.begin(), records.end());
+        return records;
+    }
+
+    // Replays solved matches into DeckStats and ELO. Records must be in match index order
+    static void record(const std::vector<MatchRecord>& records) {
+        for (const auto& match : records)
+            DeckStats::recordMatch(match);
+    }
+
+    // Saved next to a round robin journal: the pool and card table its results were solved against
+    static std::string poolPath(const std::string& journalPath) {
+        return journalPath + ".pool";
+    }
+
+    static std::string cardTablePath(const std::string& journalPath) {
+        return journalPath + ".cards";
+    }
+
+    /* Brings a round robin journal up to date with the current pool and card table. Results
+    for decks holding a card whose stats changed since the journal's card table was saved are
+    dropped, so only matchups involving changed cards get solved again. The pool may have
+    grown since (addIfUnique keeps existing IDs): kept results move to the new match indexes
+    and the new decks' matchups are simply missing. Leaves the still valid results in records */
+    static bool refreshJournal(const std::string& journalPath, std::vector<MatchRecord>& records) {
+        Journal::Header header;
+        if (!Journal::read(journalPath, header, records))
+            return false;
+        const int oldDeckCount = int(header.deckCount);
+        if (header.rules != Matchplay::activeRules || oldDeckCount > DeckStats::deckCount()
+            || header.poolHash != DeckStats::poolHash(oldDeckCount)) {
+            std::cout << "Tournament::refreshJournal() " << journalPath << " belongs to another deck pool or ruleset" << std::endl;
+            return false;
+        }
+
+        std::vector<bool> changedCards;
+        std::vector<bool> affected(DeckStats::deckCount(), false);
+        int affectedDecks = 0;
+        if (std::filesystem::exists(cardTablePath(journalPath))) {
+            if (!CardTable::diff(cardTablePath(journalPath), changedCards))
+                return false;
+            for (ID card = 0; card < ID(changedCards.size()); card++)
+                if (changedCards[card])
+                    for (const ID deck : DeckStats::decksWithCard(card)) {
+                        if (deck >= oldDeckCount)
+                            break; // Ascending, so the rest were added since
+                        if (!affected[deck]) {
+                            affected[deck] = true;
+                            affectedDecks++;
+                        }
+                    }
+        }
+
+        const size_t stored = records.size();
+        std::vector<MatchRecord> kept;
+        kept.reserve(stored);
+        for (MatchRecord match : records)
+            if (!affected[match.redDeck] && !affected[match.blueDeck]) {
+                match.matchIndex = MatchRecord::indexOf(DeckPairs::indexOf(match.redDeck, match.blueDeck, DeckStats::deckCount()),
+                    match.redDeck > match.blueDeck);
+                kept.push_back(match);
+            }
+        records = std::move(kept);
+
+        if (affectedDecks > 0 || oldDeckCount != DeckStats::deckCount()) {
+            std::cout << "Re-rating: " << affectedDecks << " of " << oldDeckCount << " decks hold changed cards, "
+                << DeckStats::deckCount() - oldDeckCount << " decks added, " << stored - records.size() << " of "
+                << stored << " stored results dropped" << std::endl;
+            if (!Journal::rewrite(journalPath, Journal::makeHeader(0, Matchplay::activeRules), records))
+                return false;
+        }
+        return true;
+    }
+
+    /* Every pair of decks plays twice, once from each side, under Matchplay::activeRules.
+    Given a journal path, solved matches are journaled as they finish and a rerun after a
+    crash, a card table change or pool growth solves only what the journal lacks (see
+    refreshJournal()). Ratings are order dependent, so results are replayed in match order:
+    the match index range is walked SCHEDULE_CHUNK indexes at a time, each step solving what
+    the journal lacks and replaying its fresh and journaled results merged before the next
+    starts. Memory is bounded by the chunk and the journal, never by the whole schedule */
+    static constexpr uint64_t SCHEDULE_CHUNK = 1 << 20;    // Match indexes solved and replayed per step
+
+    static void playAllMatchupsOnce(unsigned int threads = Matchplay::solverThreads, const std::string& journalPath = "") {
+        const uint64_t matches = 2 * DeckPairs::pairCount(DeckStats::deckCount());
+        Journal::Writer journal;
+        std::vector<MatchRecord> records;
+        if (!journalPath.empty()) {
+            if (Journal::started(journalPath) && !refreshJournal(journalPath, records))
+                return;
+            if (!journal.open(journalPath, Journal::makeHeader(0, Matchplay::activeRules)))
+                return;
+            // --rerate needs both to make sense of the journal, so a run that can't save them stops here
+            if (!PoolFile::save(poolPath(journalPath)) || !CardTable::save(cardTablePath(journalPath)))
+                return;
+        }
+
+        std::function<void(const MatchRecord&)> onSolved = nullptr;
+        if (!journalPath.empty())
+            onSolved = [&](const MatchRecord& match) { journal.append(match); };
+
+        std::sort(records.begin(), records.end());
+        auto journaled = records.cbegin();
+        std::vector<uint64_t> matchIndexes;
+        std::vector<MatchRecord> fresh, merged;
+        uint64_t simulated = 0;
+        for (uint64_t first = 0; first < matches; first += SCHEDULE_CHUNK) {
+            const uint64_t last = std::min(matches, first + SCHEDULE_CHUNK);
+            const auto chunkJournaled = journaled;
+            matchIndexes.clear();
+            for (uint64_t i = first; i < last; i++) {
+                const auto held = journaled;
+                while (journaled != records.cend() && journaled->matchIndex == i)
+                    journaled++;
+                if (journaled == held)
+                    matchIndexes.push_back(i);
+            }
+
+            fresh.clear();
+            if (!matchIndexes.empty())
+                Rules::dispatch(Matchplay::activeRules, [&](auto ruleset) {
+                    fresh = solveMatches<decltype(ruleset)>(matchIndexes, threads, onSolved);
+                });
+            merged.clear();
+            std::merge(fresh.cbegin(), fresh.cend(), chunkJournaled, journaled, std::back_inserter(merged));
+            record(merged);
+            simulated += matchIndexes.size();
+        }
+        journal.close();
+        std::cout << "Games simulated: " << simulated << " (" << records.size() << " from the journal)" << std::endl;
+    }
+
+    /* Swiss system: a round robin is O(n^2) solves, so large pools are ranked by rounds
+    instead, each pairing decks with similar scores that haven't met yet. Each pairing plays
+    both legs, and about log2(n) rounds separate the field, for O(n log n) solves in total */
+    static constexpr int SWISS_WINDOW = 64;  // Decks looked ahead for an opponent before giving a bye
+    static constexpr double SWISS_BYE_POINTS = 1.0; // Half the two legs' points: a bye neither helps nor hurts
+
+    struct SwissResult {
+        std::vector<ID> ranking;    // Best first
+        uint64_t solves = 0;
+    };
+
+    static SwissResult playSwiss(int rounds = 0, unsigned int threads = Matchplay::solverThreads) {
+        const int deckCount = DeckStats::deckCount();
+        if (rounds <= 0)
+            rounds = int(std::ceil(std::log2(std::max(2, deckCount)))) + 2;
+
+        std::vector<double> score(deckCount, 0.0);
+        std::vector<std::vector<ID>> opponents(deckCount);
+        SwissResult result;
+
+        for (int round = 0; round < rounds; round++) {
+            // Score groups top down, ELO then ID breaking ties so pairings are deterministic
+            std::vector<ID> order(deckCount);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](ID a, ID b) {
+                if (score[a] != score[b]) return score[a] > score[b];
+                if (ELO::getElo(a) != ELO::getElo(b)) return ELO::getElo(a) > ELO::getElo(b);
+                return a < b;
+            });
+
+            std::vector<bool> paired(deckCount, false);
+            std::vector<uint64_t> matchIndexes;
+            for (int i = 0; i < deckCount; i++) {
+                const ID deck = order[i];
+                if (paired[deck])
+                    continue;
+                paired[deck] = true;
+
+                int looked = 0;
+                ID opponent = -1;
+                for (int j = i + 1; j < deckCount && looked < SWISS_WINDOW; j++) {
+                    const ID candidate = order[j];
+                    if (paired[candidate])
+                        continue;
+                    looked++;
+                    if (!DeckStats::hasPlayedAgainst(deck, candidate)) {
+                        opponent = candidate;
+                        break;
+                    }
+                }
+
+                if (opponent < 0) {
+                    score[deck] += SWISS_BYE_POINTS;
+                    continue;
+                }
+                paired[opponent] = true;
+                opponents[deck].push_back(opponent);
+                opponents[opponent].push_back(deck);
+                const uint64_t pair = DeckPairs::indexOf(deck, opponent, deckCount);
+                matchIndexes.push_back(MatchRecord::indexOf(pair, 0));
+                matchIndexes.push_back(MatchRecord::indexOf(pair, 1));
+            }
+
+            Rules::dispatch(Matchplay::activeRules, [&](auto ruleset) {
+                const auto records = solveMatches<decltype(ruleset)>(matchIndexes, threads);
+                record(records);
+                for (const auto& match : records) {
+                    score[match.redDeck] += match.redPoints();
+                    score[match.blueDeck] += 1.0 - match.redPoints();
+                }
+            });
+            result.solves += matchIndexes.size();
+        }
+
+        // Final standings: score, then Buchholz (opponents' total score), then ELO
+        std::vector<double> buchholz(deckCount, 0.0);
+        for (ID deck = 0; deck < deckCount; deck++)
+            for (const ID opponent : opponents[deck])
+                buchholz[deck] += score[opponent];
+
+        result.ranking.resize(deckCount);
+        std::iota(result.ranking.begin(), result.ranking.end(), 0);
+        std::sort(result.ranking.begin(), result.ranking.end(), [&](ID a, ID b) {
+            if (score[a] != score[b]) return score[a] > score[b];
+            if (buchholz[a] != buchholz[b]) return buchholz[a] > buchholz[b];
+            if (ELO::getElo(a) != ELO::getElo(b)) return ELO::getElo(a) > ELO::getElo(b);
+            return a < b;
+        });
+        return result;
+    }
+
+    // Spearman correlation between two rankings of the same decks
+    static double rankCorrelation(const std::vector<ID>& first, const std::vector<ID>& second) {
+        const size_t n = first.size();
+        if (n < 2)
+            return 1.0;
+        std::vector<size_t> position(n);
+        for (size_t i = 0; i < n; i++)
+            position[second[i]] = i;
+        double squaredDifferences = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            const double difference = double(i) - double(position[first[i]]);
+            squaredDifferences += difference * difference;
+        }
+        return 1.0 - 6.0 * squaredDifferences / (double(n) * (double(n) * double(n) - 1.0));
+    }
+
+    /* How much ranking quality Swiss gives up: ranks the current pool by a full round robin's
+    ratings (DeckStats::ratingSystem), then again by Swiss, and compares the two. Leaves the
+    Swiss results recorded */
+    static void compareSwissToRoundRobin(int topK = 10, int rounds = 0, unsigned int threads = Matchplay::solverThreads) {
+        const int deckCount = DeckStats::deckCount();
+
+        DeckStats::resetResults();
+        playAllMatchupsOnce(threads);
+        const std::vector<ID> roundRobin = DeckStats::topDecks(deckCount);
+
+        DeckStats::resetResults();
+        const SwissResult swiss = playSwiss(rounds, threads);
+
+        topK = std::min(topK, deckCount);
+        int sharedTop = 0;
+        for (int i = 0; i < topK; i++)
+            sharedTop += std::find(swiss.ranking.begin(), swiss.ranking.begin() + topK, roundRobin[i]) != swiss.ranking.begin() + topK;
+
+        std::cout << "----------------------- Swiss vs Round Robin -----------------------" << std::endl;
+        std::cout << "Decks: " << deckCount
+            << " | Round robin solves: " << 2 * DeckPairs::pairCount(deckCount)
+            << " | Swiss solves: " << swiss.solves << std::endl;
+        std::cout << "Rank correlation: " << std::setprecision(3) << rankCorrelation(swiss.ranking, roundRobin)
+            << " | Top " << topK << " shared: " << sharedTop << std::endl;
+    }
+
+    /* Adaptive matchmaking for a trustworthy top K: Glicko deviations say which decks could
+    still be on either side of the top-K boundary, and each batch plays the unplayed pairings
+    expected to shrink that doubt the most. The run stops once the top K is stable to the
+    given confidence: either the expected number of decks on the wrong side of the boundary is
+    at most (1 - confidence) * K, or the top K has not changed for n batches, n being where zero
+    changes bounds the per-batch change rate at 1 - confidence (the rule of three, generalised).
+    Decks rated level at the boundary rarely pass the first test, as each pair only plays once */
+    static int stableBatchesNeeded(double confidence) {
+        return int(std::ceil(-std::log(1.0 - confidence) / (1.0 - confidence)));
+    }
+    static double topKBoundary(const std::vector<ID>& ranked, int topK) {
+        return (Glicko::rating(ranked[topK - 1]) + Glicko::rating(ranked[topK])) / 2.0;
+    }
+
+    // Chance the deck's true rating lies on the other side of the boundary
+    static double misplacedChance(ID deck, double boundary) {
+        const double z = std::abs(Glicko::rating(deck) - boundary) / Glicko::deviation(deck);
+        return 0.5 * std::erfc(z / std::sqrt(2.0));
+    }
+
+    // Doubt removed about where the deck stands, weighted by how much doubt there is
+    static double informationGain(ID deck, ID opponent, double boundary) {
+        const double before = Glicko::deviation(deck);
+        const double after = Glicko::deviationAfterGame(deck, opponent);
+        return misplacedChance(deck, boundary) * (before * before - after * after);
+    }
+
+    struct AdaptiveResult {
+        std::vector<ID> topDecks;
+        uint64_t solves = 0;
+        bool converged = false;
+    };
+
+    static AdaptiveResult playAdaptive(int topK, double confidence = 0.95, uint64_t maxSolves = UINT64_MAX,
+        unsigned int threads = Matchplay::solverThreads) {
+        const int deckCount = DeckStats::deckCount();
+        const int batchPairs = std::max(1u, threads) * 4;
+        AdaptiveResult result;
+        if (topK <= 0 || topK >= deckCount) {
+            std::cout << "Tournament::playAdaptive() needs 0 < topK < deckCount" << std::endl;
+            return result;
+        }
+
+        std::vector<ID> previousTop;
+        int stableBatches = 0;
+        while (result.solves < maxSolves) {
+            const std::vector<ID> ranked = Glicko::getTopDecks(deckCount);
+            const double boundary = topKBoundary(ranked, topK);
+
+            std::vector<ID> top(ranked.begin(), ranked.begin() + topK);
+            std::sort(top.begin(), top.end());
+            stableBatches = (top == previousTop) ? stableBatches + 1 : 0;
+            previousTop = top;
+
+            double expectedMisplaced = 0.0;
+            std::vector<std::pair<double, ID>> focus;
+            for (const ID deck : ranked) {
+                const double chance = misplacedChance(deck, boundary);
+                expectedMisplaced += chance;
+                focus.push_back({ chance, deck });
+            }
+            if (expectedMisplaced <= (1.0 - confidence) * topK || stableBatches >= stableBatchesNeeded(confidence)) {
+                result.converged = true;
+                break;
+            }
+
+            // Most doubtful decks first, each paired with the opponent that tells it most
+            std::sort(focus.begin(), focus.end(), [](const auto& a, const auto& b) {
+                return a.first != b.first ? a.first > b.first : a.second < b.second;
+            });
+            std::vector<bool> busy(deckCount, false);
+            std::vector<uint64_t> matchIndexes;
+            for (const auto& [chance, deck] : focus) {
+                if (int(matchIndexes.size()) >= 2 * batchPairs)
+                    break;
+                if (busy[deck])
+                    continue;
+
+                ID bestOpponent = -1;
+                double bestGain = 0.0;
+                for (ID opponent = 0; opponent < deckCount; opponent++) {
+                    if (opponent == deck || busy[opponent] || DeckStats::hasPlayedAgainst(deck, opponent))
+                        continue;
+                    const double gain = informationGain(deck, opponent, boundary) + informationGain(opponent, deck, boundary);
+                    if (gain > bestGain) {
+                        bestGain = gain;
+                        bestOpponent = opponent;
+                    }
+                }
+                if (bestOpponent < 0)
+                    continue;
+
+                busy[deck] = busy[bestOpponent] = true;
+                const uint64_t pair = DeckPairs::indexOf(deck, bestOpponent, deckCount);
+                matchIndexes.push_back(MatchRecord::indexOf(pair, 0));
+                matchIndexes.push_back(MatchRecord::indexOf(pair, 1));
+            }
+            if (matchIndexes.empty())
+                break; // Every informative pairing has been played
+
+            Rules::dispatch(Matchplay::activeRules, [&](auto ruleset) {
+                record(solveMatches<decltype(ruleset)>(matchIndexes, threads));
+            });
+            result.solves += matchIndexes.size();
+        }
+
+        result.topDecks = Glicko::getTopDecks(topK);
+        std::cout << "Adaptive top " << topK << ": " << result.solves << " solves, "
+            << (result.converged ? "converged" : "stopped before convergence") << std::endl;
+        return result;
+    }
+
+    /* Adds random legal decks until the pool holds deckCount. Candidates are drawn in fixed
+    size blocks, block b from Random::stream(seed, b), on all threads at once, then added in
+    block order: the pool depends on the seed alone, whatever the thread count */
+    static void generatePool(uint64_t seed, int deckCount, unsigned int threads = Matchplay::solverThreads) {
+        uint64_t firstBlock = 0;
+        while (DeckStats::deckCount() < deckCount) {
+            const uint64_t blocks = (deckCount - DeckStats::deckCount() + POOL_BLOCK - 1) / POOL_BLOCK;
+            std::vector<std::vector<CardContainer>> candidates(blocks);
+            std::atomic<uint64_t> nextBlock{ 0 };
+            auto worker = [&]() {
+                for (uint64_t block = nextBlock++; block < blocks; block = nextBlock++) {
+                    Random::Generator rng = Random::stream(seed, firstBlock + block);
+                    candidates[block].reserve(POOL_BLOCK);
+                    for (int i = 0; i < POOL_BLOCK; i++)
+                        candidates[block].push_back(DeckStats::createWithMaxStars(rng));
+                }
+            };
+
+            std::vector<std::thread> workers;
+            for (unsigned int i = 1; i < std::min<uint64_t>(threads, blocks); i++)
+                workers.emplace_back(worker);
+            worker();
+            for (auto& thread : workers)
+                thread.join();
+
+            // Duplicates are dropped, so a few more blocks may be needed
+            for (const auto& block : candidates)
+                for (const auto& deck : block)
+                    if (DeckStats::deckCount() < deckCount)
+                        DeckStats::addIfUnique(deck);
+            firstBlock += blocks;
+        }
+    }
+
+    /* Sharded tournaments: shard k of N solves the deck pairs whose index is k mod N, and
+    appends each result to its own shard file as it finishes. Every shard regenerates the
+    deck pool from the same seed, and the shard header records the pool's hash so shards
+    and merges can't be mixed across pools. Rerunning a shard skips what its file already holds */
+    static std::vector<uint64_t> shardMatchIndexes(uint32_t shardIndex, uint32_t shardCount,
+        const std::unordered_set<uint64_t>& solved) {
+        std::vector<uint64_t> matchIndexes;
+        const uint64_t pairs = DeckPairs::pairCount(DeckStats::deckCount());
+        for (uint64_t pair = shardIndex; pair < pairs; pair += shardCount)
+            for (int leg = 0; leg < 2; leg++)
+                if (solved.find(MatchRecord::indexOf(pair, leg)) == solved.end())
+                    matchIndexes.push_back(MatchRecord::indexOf(pair, leg));
+        return matchIndexes;
+    }
+
+    // Expects the pool from generatePool(seed, ...)
+    static bool playShard(uint32_t shardIndex, uint32_t shardCount, uint64_t seed, const std::string& path,
+        unsigned int threads = Matchplay::solverThreads) {
+        if (shardCount == 0 || shardIndex >= shardCount) {
+            std::cout << "Tournament::playShard() invalid shard " << shardIndex << " of " << shardCount << std::endl;
+            return false;
+        }
+
+        const ShardFile::Header header = ShardFile::makeHeader(seed, DeckStats::poolHash(),
+            DeckStats::deckCount(), Matchplay::activeRules, shardIndex, shardCount);
+
+        std::unordered_set<uint64_t> solved;
+        if (ShardFile::started(path)) {
+            ShardFile::Header existing;
+            std::vector<MatchRecord> records;
+            if (!ShardFile::read(path, existing, records))
+                return false;
+            if (!existing.sameTournament(header) || existing.shardIndex != shardIndex || existing.shardCount != shardCount) {
+                std::cout << "Tournament::playShard() " << path << " belongs to a different shard or deck pool" << std::endl;
+                return false;
+            }
+            for (const auto& match : records)
+                solved.insert(match.matchIndex);
+            std::cout << "Resuming shard with " << solved.size() << " matches already solved" << std::endl;
+        }
+
+        ShardFile::Writer writer;
+        if (!writer.open(path, header))
+            return false;
+
+        const auto matchIndexes = shardMatchIndexes(shardIndex, shardCount, solved);
+        Rules::dispatch(Matchplay::activeRules, [&](auto ruleset) {
+            solveMatches<decltype(ruleset)>(matchIndexes, threads,
+                [&](const MatchRecord& match) { writer.append(match); });
+        });
+
+        std::cout << "Shard " << shardIndex << " of " << shardCount << " finished: "
+            << solved.size() + matchIndexes.size() << " matches" << std::endl;
+        return true;
+    }
+
+    // Combines shard files solved against the current pool into DeckStats and ELO
+    static bool mergeShards(const std::vector<std::string>& paths) {
+        std::vector<MatchRecord> records;
+        ShardFile::Header first{};
+        for (size_t i = 0; i < paths.size(); i++) {
+            ShardFile::Header header;
+            if (!ShardFile::read(paths[i], header, records))
+                return false;
+            if (i == 0)
+                first = header;
+            if (!header.sameTournament(first) || header.poolHash != DeckStats::poolHash()) {
+                std::cout << "Tournament::mergeShards() " << paths[i] << " was solved against a different deck pool or rules" << std::endl;
+                return false;
+            }
+        }
+
+        // A shard may be merged twice or overlap another run: keep one record per match
+        std::sort(records.begin(), records.end());
+        records.erase(std::unique(records.begin(), records.end(),
+            [](const MatchRecord& a, const MatchRecord& b) { return a.matchIndex == b.matchIndex; }), records.end());
+
+        const uint64_t expected = 2 * DeckPairs::pairCount(DeckStats::deckCount());
+        if (records.size() < expected)
+            std::cout << "Warning: merging " << records.size() << " of " << expected << " matches, some shards are incomplete" << std::endl;
+
+        Matchplay::activeRules = first.rules;
+        record(records);
+        std::cout << "Merged " << records.size() << " matches from " << paths.size() << " shards" << std::endl;
+        return true;
+    }
+
+    // Sets Matchplay::activeRules from a command line argument, unless it isn't a valid combination of rule flags
+    static bool parseRules(const char* text) {
+        char* end = nullptr;
+        const unsigned long flags = std::strtoul(text, &end, 10);
+        if (end == text || *end != '\0' || (flags & ~(unsigned long)(Rules::ALL_RULES | Rules::SUDDEN_DEATH | Rules::SWAP))
+            || !Rules::isValid(Rules::Flags(flags))) {
+            std::cout << "Invalid rules: " << text << std::endl;
+            return false;
+        }
+        Matchplay::activeRules = Rules::Flags(flags);
+        return true;
+    }
+
+    /* Headless entry points:
+    --shard <k> <N> <seed> <decks> <rules> <file>   Solve shard k of N, resuming <file> if it exists
+    --merge <seed> <decks> <files...>               Merge shard files and print the best decks */
+    static int runCommandLine(int argc, char* argv[]) {
+        // A leading --cache <file> serves repeated matchups from a ResultCache
+        if (argc > 3 && std::string(argv[1]) == "--cache") {
+            if (!ResultCache::open(argv[2]))
+                return 1;
+            argv[2] = argv[0];
+            const int result = runCommandLine(argc - 2, argv + 2);
+            ResultCache::printStats();
+            ResultCache::close();
+            return result;
+        }
+        // A leading --bradley-terry ranks decks by a batch fit over every game instead of sequential ELO
+        if (argc > 2 && std::string(argv[1]) == "--bradley-terry") {
+            DeckStats::ratingSystem = DeckStats::BRADLEY_TERRY;
+            argv[1] = argv[0];
+            return runCommandLine(argc - 1, argv + 1);
+        }
+        // A leading --matchups <file> keeps the matchup matrix in a memory-mapped scratch file
+        if (argc > 3 && std::string(argv[1]) == "--matchups") {
+            if (!DeckStats::mapMatchups(argv[2]))
+                return 1;
+            argv[2] = argv[0];
+            return runCommandLine(argc - 2, argv + 2);
+        }
+
+        const std::string mode = argv[1];
+        if (mode == "--shard" && argc == 8 && parseRules(argv[6])) {
+            generatePool(std::strtoull(argv[4], nullptr, 10), std::atoi(argv[5]));
+            return playShard(std::atoi(argv[2]), std::atoi(argv[3]), std::strtoull(argv[4], nullptr, 10), argv[7]) ? 0 : 1;
+        }
+        // Re-rates a journaled round robin after a patch, on its saved pool plus any new random decks
+        if (mode == "--rerate" && (argc == 4 || argc == 5) && parseRules(argv[2])) {
+            if (!PoolFile::load(poolPath(argv[3])))
+                return 1;
+            if (argc == 5) // New decks seeded by the saved pool, so a repeated re-rate adds the same ones
+                generatePool(DeckStats::poolHash(), DeckStats::deckCount() + std::atoi(argv[4]));
+            playAllMatchupsOnce(Matchplay::solverThreads, argv[3]);
+            DeckStats::printBestPerforming(10);
+            return 0;
+        }
+        if ((mode == "--random" || mode == "--roundrobin") && argc == 6 && parseRules(argv[4])) {
+            generatePool(std::strtoull(argv[2], nullptr, 10), std::atoi(argv[3]));
+            if (mode == "--random")
+                Matchplay::playMatchupsRandomlyJournaled(argv[5], std::strtoull(argv[2], nullptr, 10));
+            else
+                playAllMatchupsOnce(Matchplay::solverThreads, argv[5]);
+            DeckStats::printBestPerforming(10);
+            return 0;
+        }
+        if (mode == "--merge" && argc >= 5) {
+            generatePool(std::strtoull(argv[2], nullptr, 10), std::atoi(argv[3]));
+            if (!mergeShards(std::vector<std::string>(argv + 4, argv + argc)))
+                return 1;
+            DeckStats::printBestPerforming(10);
+            return 0;
+        }
+
+        std::cout << "Usage: [--cache <file>] [--matchups <file>] [--bradley-terry] --shard <k> <N> <seed> <decks> <rules> <file> | --merge <seed> <decks> <files...>"
+            << " | --random <seed> <decks> <rules> <journal> | --roundrobin <seed> <decks> <rules> <journal>"
+            << " | --rerate <rules> <journal> [new decks]" << std::endl;
+        std::cout << "<rules> sums the Rules::Rule flags; Ascension and Descension, or Order and Chaos, can't be combined" << std::endl;
+        return 1;
+    }
+}
@@ -1,10 +1,12 @@
 #pragma once
 #include "defs.hpp"
 #include <unordered_map>
+#include <cstdint>
 
 struct TranspositionEntry {
     Player result;  // Stores the determined game outcome (PLAYER_RED, PLAYER_BLUE, or PLAYER_NONE)
     int depth;      // Depth at which this position was analyzed
+    double value;   // Expected score for RED under Chaos (+1 win, 0 draw, -1 loss)
 };
 
-inline static std::unordered_map<int, TranspositionEntry> transpositionTable;
\ No newline at end of file
+inline static thread_local std::unordered_map<uint64_t, TranspositionEntry> transpositionTable;
\ No newline at end of file
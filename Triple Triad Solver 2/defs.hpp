@@ -19,6 +19,16 @@ enum Player {
     PLAYER_NONE
 };
 
+// Card types used by the Ascension / Descension rules
+enum CardType {
+    TYPE_NONE,
+    PRIMAL,
+    SCION,
+    BEASTMAN,
+    GARLEAN,
+    TYPE_COUNT
+};
+
 using ID = int;
 using CardContainer = std::vector<ID>;
 
@@ -1,6 +1,14 @@
 #pragma once
 #include "defs.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 static unsigned char attributeToChar(int value) {
     switch (value) {
@@ -79,6 +87,60 @@ static Player otherPlayer(Player player) {
         return PLAYER_RED;
 }
 
+// Numeric value of an edge, counting an A as 10 (used by the Plus rule sums)
+static int attributeRank(const int value) {
+    return value == STRENGTH_MAX ? 10 : value;
+}
+
+// Inverse of attributeRank(), with ranks clamped to the 1-A range that modifiers may not leave
+static int rankToAttribute(const int rank) {
+    if (rank >= 10)
+        return STRENGTH_MAX;
+    return rank < 1 ? 1 : rank;
+}
+
+// SplitMix64 finalizer: spreads any 64-bit input over all 64 output bits
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Set bits in x. MSVC's 64-bit intrinsic is x64-only, so it counts two halves
+static int popcount64(uint64_t x) {
+#ifdef _MSC_VER
+    return int(__popcnt(uint32_t(x)) + __popcnt(uint32_t(x >> 32)));
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// ELO points per unit of log-odds: 400 / ln 10
+static constexpr double ELO_PER_LOGIT = 400.0 / 2.302585092994046;
+
+// Runs f(first, last, thread) over [0, count) split into one contiguous range per thread
+template <typename F>
+static void parallelRanges(int count, unsigned int threads, F&& f) {
+    threads = std::max(1u, std::min(threads, unsigned(std::max(count, 1))));
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threads; t++)
+        workers.emplace_back(f, int(uint64_t(count) * t / threads), int(uint64_t(count) * (t + 1) / threads), t);
+    f(0, int(uint64_t(count) / threads), 0u);
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// Binomial coefficient n choose k, 0 when k > n
+static uint64_t choose(uint64_t n, int k) {
+    if (k < 0 || uint64_t(k) > n)
+        return 0;
+    uint64_t result = 1;
+    for (int i = 1; i <= k; i++)
+        result = result * (n - k + i) / i; // Exact: each prefix is itself a binomial coefficient
+    return result;
+}
+
 static int square(const int value) {
     return value * value;
 }
\ No newline at end of file
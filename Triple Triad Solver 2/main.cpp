@@ -1,17 +1,41 @@
-#include <cstdlib>  // For rand()
+#include <cstdlib>
 #include <ctime>    // For time()
+#include <string>
 #include "Graphics.hpp"
 #include "Matchplay.hpp"
+#include "Benchmark.hpp"
+#include "Tournament.hpp"
+#include "Random.hpp"
 
 // Main game loop
-int main() {
-    std::srand(static_cast<int>(std::time(0)));  // Seed RNG
+int main(int argc, char* argv[]) {
+    // A leading --seed <n> replays an earlier session; otherwise the clock picks one
+    uint64_t seed = uint64_t(std::time(0));
+    if (argc > 2 && std::string(argv[1]) == "--seed") {
+        seed = std::strtoull(argv[2], nullptr, 10);
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+    std::cout << "Seed: " << seed << std::endl; // Reruns with --seed and this seed reproduce the session
+    Random::Generator rng(seed);
     CardCollection::init();
-    DeckStats::initWithMaxStars(750);
+
+    // Consistency checks on a random pool, then exit
+    if (argc == 2 && std::string(argv[1]) == "--check") {
+        DeckStats::initWithMaxStars(750, rng);
+        return Benchmark::runChecks() ? 0 : 1;
+    }
+
+    // Sharded tournament runs and merges skip the graphical session
+    if (argc > 1)
+        return Tournament::runCommandLine(argc, argv);
+
+    DeckStats::initWithMaxStars(750, rng);
 
     Graphics::init();
    
-    Matchplay::graphicallyResimulateMatchManual(DeckStats::randomID(), DeckStats::randomID());
+    Matchplay::graphicallyResimulateMatchManual(DeckStats::randomID(rng), DeckStats::randomID(rng));
     
     Graphics::cleanup();
     return 0;